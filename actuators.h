@@ -0,0 +1,15 @@
+#ifndef ACTUATORS_H
+#define ACTUATORS_H
+
+#include "core.h"
+
+/* the X actuators share a connection, so they share a lane */
+enum {inlineLane, xLane, driversLane};
+
+extern Actuator const rotateActuator;     /* xact.c: XRandR rotation of DSI-1 */
+extern Actuator const inputActuator;      /* xact.c: XInput halo keyboard enable */
+extern Actuator const backlightActuator;  /* backlight.c: screen and keyboard backlight */
+extern Actuator const driversActuator;    /* i2cdrv.c: Goodix/Wacom bind and unbind */
+extern Actuator const tabletModeActuator; /* tabletsw.c: uinput SW_TABLET_MODE */
+
+#endif
@@ -0,0 +1,140 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "sensor.h"
+#include "core.h"
+#include "actuators.h"
+#include "ringlog.h"
+#include "reactor.h"
+
+/* Target changes smaller than this (in the 0.15..1 scale) are not seen. */
+#define blThreshold 0.03
+/* A full 0..1 swing takes this long, smaller ones proportionally less. */
+#define blRampMs 600
+/* The values written are quantized to this many steps. */
+#define blSteps 100
+/* A ramp moves on its own timer, at this period. */
+#define blStepMs 20
+
+static int blFd = -1, kbFd = -1, rampTimer = -1, rampArmed = 0;
+static double backlightMax = 0.0;
+static double pwmMax = 0.0;
+static Sensor kbDutyCycle;
+
+typedef struct Ramp {
+    double target, cur;
+    long long lastNs;
+    int written;        /* last quantized step written, -1 before the first */
+} Ramp;
+
+static Ramp bl = {0, 0, 0, -1}, kb = {0, 0, 0, -1};
+
+static void writeLevel(int fd, double val) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), "%.0f", val);
+    if (fd >= 0 && pwrite(fd, buf, len, 0) != len) perror("cannot set backlight");
+}
+
+static int openLevel(char const *fn) {
+    char path[PATH_MAX];
+    if (sysPath(path, PATH_MAX, "%s", fn)) return -1;
+    return open(path, O_WRONLY | O_CLOEXEC);
+}
+
+static void onRampTimer(void *ctx, int fd);
+
+static void initBacklight() {
+    char devName[PATH_MAX];
+    sysPath(devName, PATH_MAX, "/sys/class/backlight/intel_backlight/max_brightness");
+    backlightMax = readFloat(devName);
+    if (backlightMax == 0.0) {
+        perror("cannot read backlight max value.");
+        exit(14);
+    }
+    sysPath(devName, PATH_MAX, "/sys/class/pwm/pwmchip1/pwm0/period");
+    pwmMax = readFloat(devName);
+    if (pwmMax == 0.0) {
+        perror("cannot read keyboard backlight max value.");
+        exit(15);
+    }
+    blFd = openLevel("/sys/class/backlight/intel_backlight/brightness");
+    kbFd = openLevel("/sys/class/pwm/pwmchip1/pwm0/duty_cycle");
+    sysPath(devName, PATH_MAX, "/sys/class/pwm/pwmchip1/pwm0/duty_cycle");
+    openSensor(&kbDutyCycle, devName);
+    rampTimer = watchTimer(0, onRampTimer, NULL, timeRampHandled);
+}
+
+static void retarget(Ramp *r, double target, int jump) {
+    if (jump) r->cur = target;
+    if (target != r->target)
+        logAction(logBacklight, lround(target * 1000), 0, r == &bl ? "screen" : "keyboard");
+    r->target = target;
+}
+
+/* Moves cur toward target by what the time since the last step allows;
+ * returns the quantized step, changed or not. */
+static int stepRamp(Ramp *r, long long now) {
+    double dt = r->lastNs ? (now - r->lastNs) / (blRampMs * 1000000.0) : 1.0;
+    r->lastNs = now;
+    if (fabs(r->target - r->cur) <= dt) r->cur = r->target;
+    else r->cur += r->target > r->cur ? dt : -dt;
+    return lround(r->cur * blSteps);
+}
+
+static Formfactor lastFF = undefinedFF;
+
+static int ramping() {
+    return bl.cur != bl.target || kb.cur != kb.target;
+}
+
+/* Writes both backlights where their ramps are now. The keyboard one is
+ * left off if someone else turned it off. */
+static void stepRamps(long long now) {
+    int step = stepRamp(&bl, now);
+    if (step != bl.written) writeLevel(blFd, (bl.written = step) * backlightMax / blSteps);
+    if (undefinedFF == lastFF) return;
+    step = stepRamp(&kb, now);
+    if (step == kb.written) return;
+    if (kb.written >= 0 && 0.0 == readSensor(&kbDutyCycle)) {
+        kb.written = 0;
+        retarget(&kb, 0, 1);
+        return;
+    }
+    writeLevel(kbFd, (kb.written = step) * pwmMax / blSteps);
+}
+
+/* runs while a ramp does, so the sampling need not */
+static void armRamp() {
+    if (rampArmed == ramping() || rampTimer < 0) return;
+    rampArmed = !rampArmed;
+    setTimer(rampTimer, rampArmed ? blStepMs : 0);
+}
+
+static void onRampTimer(void *ctx, int fd) {
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations)) return;
+    stepRamps(nowNs());
+    armRamp();
+}
+
+/* Both backlights follow the ALS through a ramp and are only written when
+ * their quantized value changes. The keyboard backlight is off in tablet
+ * mode. */
+static void applyBacklight(Decision const *d) {
+    /* a new ramp starts now, not at the last sample, which may be long ago */
+    if (!ramping()) bl.lastNs = kb.lastNs = d->now;
+    if (bl.written < 0 || fabs(d->backlight - bl.target) >= blThreshold)
+        retarget(&bl, d->backlight, bl.written < 0);
+    if (d->ff != undefinedFF && d->ff != borderFF && d->ff != lastFF) {
+        lastFF = d->ff;
+        retarget(&kb, laptop == lastFF ? bl.target : 0, 1);
+        kb.written = -1;
+    } else if (laptop == lastFF && kb.written > 0) retarget(&kb, bl.target, 0);
+    stepRamps(d->now);
+    armRamp();
+}
+
+Actuator const backlightActuator = {"backlight", 1, initBacklight, applyBacklight, NULL};
@@ -0,0 +1,331 @@
+/* Per-tick cost of the autorotate pipeline, one JSON line per stage:
+ * ns/op, heap allocations/op, syscalls/op (all of them, when the
+ * raw_syscalls tracepoint can be counted; the read+write family ones
+ * always) and, where
+ * a display is involved, X requests/op. Sensors are read from a fake
+ * sysfs tree on tmpfs; the X stages run against $DISPLAY if it opens,
+ * e.g. an Xvfb. bench --x-check instead checks that the Xlib and XCB
+ * rotation paths leave the server in the same state. */
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <ftw.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <X11/Xatom.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/XInput2.h>
+#include "sensor.h"
+#include "core.h"
+#include "xact.h"
+#include "stats.h"
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+
+long allocs = 0;
+
+void *malloc(size_t n) { ++allocs; return __libc_malloc(n); }
+void *calloc(size_t n, size_t m) { ++allocs; return __libc_calloc(n, m); }
+void *realloc(void *p, size_t n) { ++allocs; return __libc_realloc(p, n); }
+
+typedef struct Counters {
+    long long ns;
+    long allocs;
+    long long rw, sys;
+    unsigned long xreq;
+    long xrt;
+} Counters;
+
+int procIo = -1, sysEnter = -1;
+Display *benchDisp = NULL;
+Counters overhead;
+
+long long rwSyscalls() {
+    char buf[512];
+    long long syscr = 0, syscw = 0;
+    int r = pread(procIo, buf, sizeof(buf) - 1, 0);
+    if (r <= 0) return 0;
+    buf[r] = 0;
+    char *p = strstr(buf, "syscr:");
+    if (p) syscr = atoll(p + 6);
+    p = strstr(buf, "syscw:");
+    if (p) syscw = atoll(p + 6);
+    return syscr + syscw;
+}
+
+/* Counts raw_syscalls:sys_enter for this thread, open, close, ioctl and
+ * poll included; needs tracefs and the perf permissions, -1 without. */
+int openSyscallCounter() {
+    static char const *ids[] = {"/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+        "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"};
+    long long id = -1;
+    for (int i = 0; i < 2 && id < 0; ++i) {
+        FILE *f = fopen(ids[i], "r");
+        if (f && fscanf(f, "%lld", &id) != 1) id = -1;
+        if (f) fclose(f);
+    }
+    if (id < 0) return -1;
+    struct perf_event_attr attr = {.type = PERF_TYPE_TRACEPOINT, .size = sizeof(attr),
+        .config = id, .sample_period = 0};
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+long long allSyscalls() {
+    long long n = 0;
+    if (sysEnter < 0 || read(sysEnter, &n, sizeof(n)) != sizeof(n)) return 0;
+    return n;
+}
+
+Counters snap() {
+    Counters c;
+    c.sys = allSyscalls();
+    c.rw = rwSyscalls();
+    c.allocs = allocs;
+    c.xreq = benchDisp ? XNextRequest(benchDisp) : 0;
+    c.xrt = statCounters[statXRoundTrips];
+    c.ns = nowNs();
+    return c;
+}
+
+void report(char const *stage, long n, Counters a, Counters b) {
+    char sys[32] = "null";
+    if (sysEnter >= 0) snprintf(sys, sizeof(sys), "%.2f", (double)(b.sys - a.sys - overhead.sys) / n);
+    printf("{\"stage\":\"%s\",\"ops\":%ld,\"ns_per_op\":%.1f,\"allocs_per_op\":%.2f,"
+            "\"syscalls_per_op\":%s,\"rw_syscalls_per_op\":%.2f,\"x_requests_per_op\":%.2f,"
+            "\"x_round_trips_per_op\":%.2f}\n", stage, n,
+            (double)(b.ns - a.ns) / n,
+            (double)(b.allocs - a.allocs - overhead.allocs) / n, sys,
+            (double)(b.rw - a.rw - overhead.rw) / n,
+            (double)(b.xreq - a.xreq) / n,
+            (double)(b.xrt - a.xrt) / n);
+}
+
+#define BENCH(stage, n, body) do { \
+    Counters a_ = snap(); \
+    for (long i_ = 0; i_ < (n); ++i_) { body; } \
+    report(stage, (n), a_, snap()); \
+} while (0)
+
+char fakeRoot[] = "/dev/shm/ybbench.XXXXXX";
+
+void fakeAttr(char const *path, long val) {
+    char fn[PATH_MAX], dir[PATH_MAX];
+    snprintf(fn, sizeof(fn), "%s%s", fakeRoot, path);
+    for (char *s = strchr(fn + 1, '/'); s; s = strchr(s + 1, '/')) {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(s - fn), fn);
+        mkdir(dir, 0755);
+    }
+    FILE *f = fopen(fn, "w");
+    if (!f) {
+        perror(fn);
+        exit(1);
+    }
+    fprintf(f, "%ld\n", val);
+    fclose(f);
+}
+
+void makeFakeSysfs() {
+    static long const accel[maxDevs][3] = {{512000, 3000, -850000}, {-2000, 498000, -861000},
+        {515000, 2500, -848000}, {-1800, 501000, -859000}};
+    char path[128];
+    if (!mkdtemp(fakeRoot) && !mkdtemp(strcpy(fakeRoot, "/tmp/ybbench.XXXXXX"))) {
+        perror("cannot create fake sysfs.");
+        exit(1);
+    }
+    for (int i = 0; i < maxDevs; ++i) for (int j = 0; j < 3; ++j) {
+        snprintf(path, sizeof(path), "/sys/bus/iio/devices/iio:device%d/in_accel_%c_raw", i, 'x' + j);
+        fakeAttr(path, accel[i][j]);
+    }
+    for (int i = 0; i < maxAls; ++i) {
+        snprintf(path, sizeof(path), "/sys/bus/iio/devices/iio:device%d/in_illuminance_raw", maxDevs + i);
+        fakeAttr(path, 4000);
+    }
+    fakeAttr("/sys/class/backlight/intel_backlight/max_brightness", 7500);
+    fakeAttr("/sys/class/backlight/intel_backlight/brightness", 0);
+    fakeAttr("/sys/class/pwm/pwmchip1/pwm0/period", 40000);
+    fakeAttr("/sys/class/pwm/pwmchip1/pwm0/duty_cycle", 0);
+    sysRoot = fakeRoot;
+}
+
+int rmEntry(char const *fn, struct stat const *st, int flag, struct FTW *ftw) {
+    return remove(fn);
+}
+
+/* What a rotation leaves on the server, read back with plain Xlib
+ * queries of its own rather than through the caches of either path. */
+#define maxCheckDevs 32
+
+typedef struct XState {
+    Rotation rotation;
+    int width, height, widthMM, heightMM;
+    int devs;
+    float matrix[maxCheckDevs][9];
+} XState;
+
+/* The rotation of crtc and, when rotations is given, all it can do. */
+void readXState(Display *d, RRCrtc crtc, XState *s, Rotation *rotations) {
+    Window root = DefaultRootWindow(d);
+    XSync(d, False);
+    processXEvents(d);
+    memset(s, 0, sizeof(*s));
+    XRRScreenResources *res = XRRGetScreenResourcesCurrent(d, root);
+    XRRCrtcInfo *ci = res ? XRRGetCrtcInfo(d, res, crtc) : NULL;
+    if (ci) {
+        s->rotation = ci->rotation;
+        if (rotations) *rotations = ci->rotations;
+        XRRFreeCrtcInfo(ci);
+    }
+    if (res) XRRFreeScreenResources(res);
+    int scr = DefaultScreen(d);
+    s->width = DisplayWidth(d, scr);
+    s->height = DisplayHeight(d, scr);
+    s->widthMM = DisplayWidthMM(d, scr);
+    s->heightMM = DisplayHeightMM(d, scr);
+    int n;
+    XIDeviceInfo *devs = XIQueryDevice(d, XIAllDevices, &n);
+    for (int i = 0; i < n && s->devs < maxCheckDevs; ++i) {
+        Atom type;
+        int format;
+        unsigned long items, after;
+        unsigned char *data = NULL;
+        if (XIGetProperty(d, devs[i].deviceid, xiAtoms[matrixAtom], 0, 9, False,
+                    AnyPropertyType, &type, &format, &items, &after, &data) == Success &&
+                format == 32 && items == 9)
+            memcpy(s->matrix[s->devs++], data, sizeof(s->matrix[0]));
+        if (data) XFree(data);
+    }
+    if (devs) XIFreeDeviceInfo(devs);
+}
+
+void rotateTo(Display *d, RRCrtc crtc, Orientation o, int xcb, XState *s) {
+    useXcb = xcb;
+    rotateScreen(d, o);
+    readXState(d, crtc, s, NULL);
+}
+
+/* Takes every orientation to every other one through the Xlib and then
+ * the XCB path, from the same start, and prints one JSON line per pair;
+ * nonzero if any pair does not end up turned as asked, or the two paths
+ * differ. 77 when there is no output that can take all four. The output
+ * is DSI-1 when there is one, else the primary or first connected. */
+int checkXPaths(Display *d) {
+    static Orientation const orients[] = {upward, leftward, downward, rightward};
+    RRCrtc crtc = findRROutput(d);
+    if (!crtc) {
+        rrOutputName = NULL;
+        crtc = findRROutput(d);
+    }
+    XState a, b;
+    Rotation rotations = 0;
+    if (crtc) readXState(d, crtc, &a, &rotations);
+    if ((rotations & (upward | leftward | downward | rightward)) != (upward | leftward | downward | rightward)) {
+        printf("{\"stage\":\"x_check\",\"skipped\":\"%s\"}\n", crtc ? "cannot rotate" : "no output");
+        return 77;
+    }
+    int differ = 0;
+    for (int from = 0; from < 4; ++from) for (int to = 0; to < 4; ++to) if (from != to) {
+        rotateTo(d, crtc, orients[from], 0, &a);
+        rotateTo(d, crtc, orients[to], 0, &a);
+        rotateTo(d, crtc, orients[from], 0, &b);
+        rotateTo(d, crtc, orients[to], 1, &b);
+        int turned = (a.rotation & 0xf) == orients[to] && (b.rotation & 0xf) == orients[to];
+        int same = !memcmp(&a, &b, sizeof(a));
+        differ |= !turned || !same;
+        printf("{\"stage\":\"x_check\",\"from\":\"%s\",\"to\":\"%s\",\"turned\":%d,\"same\":%d,"
+                "\"xlib\":[%d,%d,%d,%d,%d,%d],\"xcb\":[%d,%d,%d,%d,%d,%d]}\n",
+                orientName(orients[from]), orientName(orients[to]), turned, same,
+                a.rotation, a.width, a.height, a.widthMM, a.heightMM, a.devs,
+                b.rotation, b.width, b.height, b.widthMM, b.heightMM, b.devs);
+    }
+    useXcb = 0;
+    return differ;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && !strcmp(argv[1], "--x-check")) {
+        if (!(benchDisp = openDisplay())) {
+            printf("{\"stage\":\"x_check\",\"skipped\":\"no display\"}\n");
+            return 77;
+        }
+        int differ = checkXPaths(benchDisp);
+        XCloseDisplay(benchDisp);
+        return differ;
+    }
+    long n = argc > 1 ? atol(argv[1]) : 100000;
+    long nio = n / 10 > 0 ? n / 10 : 1;
+    procIo = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+    sysEnter = openSyscallCounter();
+    makeFakeSysfs();
+    init_accels();
+    init_als();
+    overhead.rw = overhead.sys = 0;
+    overhead.allocs = 0;
+    {
+        Counters a = snap(), b = snap();
+        overhead.rw = b.rw - a.rw;
+        overhead.sys = b.sys - a.sys;
+    }
+
+    BENCH("sensor_read_fopen", nio,
+        for (int i = 0; i < maxDevs; ++i) for (int j = 0; j < 3; ++j)
+            data.raw_vals[i][j] = readFloat(rawValsFileNames[i][j]);
+        for (int i = 0; i < maxAls; ++i) alsData[i] = readFloat(alsRawIllumination[i]));
+    BENCH("sensor_read", nio, read_accels(); read_als());
+
+    double sample[maxDevs][3];
+    memcpy(sample, data.raw_vals, sizeof(sample));
+    BENCH("copy_sample", n, memcpy(data.raw_vals, sample, sizeof(sample)));
+    BENCH("average", n, memcpy(data.raw_vals, sample, sizeof(sample)); calculateAverage());
+    calculateAverage();
+    rotate_keyboard_with_90_deg_over_z();
+    BENCH("cart2pol", n, convertToPolar());
+    volatile int sink;
+    BENCH("classify_polar", n, sink = getOrientationPolar() + getFormfactorPolar());
+    BENCH("classify", n, sink = getOrientation() + getFormfactor());
+    BENCH("pipeline", n,
+        memcpy(data.raw_vals, sample, sizeof(sample));
+        if (checkAccels() || checkAls()) continue;
+        calculateAverage();
+        rotate_keyboard_with_90_deg_over_z();
+        sink = getOrientation() + getFormfactor());
+    BENCH("tick_no_x", nio,
+        if (read_accels() || read_als()) continue;
+        calculateAverage();
+        rotate_keyboard_with_90_deg_over_z();
+        sink = getOrientation() + getFormfactor());
+
+    if ((benchDisp = openDisplay())) {
+        long nx = nio / 10 > 0 ? nio / 10 : 1;
+        BENCH("x_steady_tick", nio, processXEvents(benchDisp); XFlush(benchDisp));
+        /* every rotation drops the RandR cache, so each op reloads it;
+         * without DSI-1 there is nothing to turn and nothing to time */
+        if (findRROutput(benchDisp)) {
+            BENCH("x_rotation", nx,
+                rotateScreen(benchDisp, i_ & 1 ? rightward : upward);
+                processXEvents(benchDisp));
+            useXcb = 1;
+            BENCH("x_rotation_xcb", nx,
+                rotateScreen(benchDisp, i_ & 1 ? rightward : upward);
+                processXEvents(benchDisp));
+            useXcb = 0;
+        } else printf("{\"stage\":\"x_rotation\",\"skipped\":\"no DSI-1\"}\n");
+        unsigned char enabled;
+        BENCH("x_keyboard_switch", nx,
+            enabled = i_ & 1;
+            modifyProperty(benchDisp, vkbdDevs, xiAtoms[enabledAtom], XA_INTEGER, 8, &enabled, 1);
+            modifyProperty(benchDisp, vpadDevs, xiAtoms[enabledAtom], XA_INTEGER, 8, &enabled, 1);
+            XFlush(benchDisp));
+        rotateScreen(benchDisp, rightward);
+        XCloseDisplay(benchDisp);
+    } else printf("{\"stage\":\"x\",\"skipped\":\"no display\"}\n");
+
+    nftw(fakeRoot, rmEntry, 8, FTW_DEPTH | FTW_PHYS);
+    return 0;
+}
@@ -0,0 +1,700 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "sensor.h"
+#include "iiobuf.h"
+#include "iiodisc.h"
+#include "sched.h"
+#include "trace.h"
+#include "stats.h"
+#include "worker.h"
+#include "reactor.h"
+#include "statepage.h"
+#include "ringlog.h"
+#include "core.h"
+
+double readFloat(const char* fn) {
+    double rez = 0.0;
+    FILE*fl;
+    if (fl = fopen(fn, "r")) {
+        fscanf(fl, "%lf", &rez);
+        fclose(fl);
+    }
+    return rez;
+}
+
+char rawValsFileNames[maxDevs][3][maxName];
+Sensor rawVals[maxDevs][3];
+int useIioBuffer = 0;
+int useXcb = 0;
+IioBuffer iioBufs[maxDevs];
+
+/* The layout is found once for both kinds; a slot still empty after
+ * the cache gets one rescan before giving up. */
+static IioLayout layout;
+static int haveLayout = 0, accelsOpen = 0, alsOpen = 0;
+
+static int findSlots(int const *slots, int n) {
+    if (!haveLayout) {
+        discoverIio(&layout, 0);
+        haveLayout = 1;
+    }
+    for (int i = 0; i < n; ++i) if (slots[i] < 0) {
+        discoverIio(&layout, 1);
+        break;
+    }
+    for (int i = 0; i < n; ++i) if (slots[i] < 0) return 1;
+    return 0;
+}
+
+static void openAccels() {
+    for (int i = 0; i < maxDevs; ++ i) {
+        sysPath(rawValsFileNames[i][0], maxName,
+                "/sys/bus/iio/devices/iio:device%d/in_accel_x_raw", layout.accel[i]);
+        sysPath(rawValsFileNames[i][1], maxName,
+                "/sys/bus/iio/devices/iio:device%d/in_accel_y_raw", layout.accel[i]);
+        sysPath(rawValsFileNames[i][2], maxName,
+                "/sys/bus/iio/devices/iio:device%d/in_accel_z_raw", layout.accel[i]);
+        for (int j = 0; j < 3; ++j) openSensor(&rawVals[i][j], rawValsFileNames[i][j]);
+        if (!useIioBuffer || openIioBuffer(&iioBufs[i], layout.accel[i])) iioBufs[i].fd = -1;
+        if (DEBUG && useIioBuffer) printf("dev%d buffered=%d\n", layout.accel[i], iioBufs[i].fd >= 0);
+    }
+    accelsOpen = 1;
+}
+
+static void closeAccels() {
+    for (int i = 0; accelsOpen && i < maxDevs; ++i) {
+        for (int j = 0; j < 3; ++j) closeSensor(&rawVals[i][j]);
+        closeIioBuffer(&iioBufs[i]);
+    }
+    accelsOpen = 0;
+}
+
+void init_accels() {
+    char devName[PATH_MAX];
+    if (sysPath(devName, PATH_MAX, "/sys/bus/iio/devices/iio:device%d/in_accel_x_raw", INT_MAX)) {
+        perror("init_accels MAXPATHLEN not enough");
+        exit(10);
+    }
+    if (findSlots(layout.accel, maxDevs)) {
+        perror("not found all devices.");
+        exit(11);
+    }
+    openAccels();
+}
+
+char alsRawIllumination[maxAls][maxName];
+Sensor alsSensors[maxAls];
+double alsData[maxAls] = {0.0, 0.0};
+
+static void openAls() {
+    for (int i = 0; i < maxAls; ++i) {
+        sysPath(alsRawIllumination[i], maxName,
+                "/sys/bus/iio/devices/iio:device%d/in_illuminance_raw", layout.als[i]);
+        openSensor(&alsSensors[i], alsRawIllumination[i]);
+    }
+    alsOpen = 1;
+}
+
+static void closeAls() {
+    for (int i = 0; alsOpen && i < maxAls; ++i) closeSensor(&alsSensors[i]);
+    alsOpen = 0;
+}
+
+void init_als() {
+    char devName[PATH_MAX];
+    if (sysPath(devName, PATH_MAX, "/sys/bus/iio/devices/iio:device%d/in_illuminance_raw", INT_MAX)) {
+        perror("init_als MAXPATHLEN not enough");
+        exit(12);
+    }
+    if (findSlots(layout.als, maxAls)) {
+        perror("not found all devices.");
+        exit(13);
+    }
+    openAls();
+}
+
+/* A sensor that cannot be reopened has most likely come back under
+ * another index (resume, driver reload): look again, at most once a
+ * second, and reopen everything in use if all slots are found. One that
+ * was reopened fine may be another device that took its index, so the
+ * layout is checked then, until it is found right or rediscovered. */
+static void restartMotion();
+static int layoutSuspect = 0;
+
+static int reopened(Sensor *s) {
+    int r = s->reopened;
+    s->reopened = 0;
+    return r;
+}
+
+/* nonzero to drop the sample: a device is gone or not the one it was */
+static int layoutChanged(int lost) {
+    if (lost || (layoutSuspect && iioLayoutMoved(&layout))) return 1;
+    layoutSuspect = 0;
+    return 0;
+}
+
+static void rediscoverIio() {
+    static long long lastTry = 0;
+    long long now = nowNs();
+    if (lastTry && now - lastTry < 1000000000LL) return;
+    lastTry = now;
+    IioLayout l;
+    discoverIio(&l, 1);
+    for (int i = 0; accelsOpen && i < maxDevs; ++i) if (l.accel[i] < 0) return;
+    for (int i = 0; alsOpen && i < maxAls; ++i) if (l.als[i] < 0) return;
+    int als = alsOpen;
+    layout = l;
+    layoutSuspect = 0;
+    closeAccels();
+    openAccels();
+    if (als) {
+        closeAls();
+        openAls();
+    }
+    restartMotion();
+    statCount(statRediscoveries);
+    logAction(logRediscover, 0, 0, NULL);
+}
+
+static void cart2pol(const Cartezian *cart, Polar *pol) {
+    pol->alt = sqrt(cart->x * cart->x + cart->y * cart->y + cart->z * cart->z);
+    pol->lat = atan2(cart->z, sqrt(cart->x * cart->x + cart->y * cart->y)) * 180.0 / M_PI;
+    pol->lon = atan2(cart->y, cart->x) * 180.0 / M_PI;
+}
+
+int doRporting = 0;
+
+SensorData data;
+
+/* the two accelerometers of a half must agree */
+int checkAccels() {
+    int badData = 0;
+    for (int i = 0; i < 2; ++i) for (int j = 0; j < 3; ++j)
+        if (fabs(data.raw_vals[i][j] - data.raw_vals[i + 2][j]) > 100000.0) {
+            if (DEBUG) printf ("%f %f\n", data.raw_vals[i][j], data.raw_vals[i + 1][j]);
+            badData = 1;
+        }
+    if (DEBUG) printf(badData ? "naspa\n" : "bun\n");
+    return badData;
+}
+
+int read_accels() {
+    int lost = 0, buffered = useIioBuffer ? readIioScans(iioBufs, maxDevs, data.raw_vals) : 0;
+    for (int i = 0; i < maxDevs; ++i) {
+        long long t0 = nowNs();
+        if (!(buffered & 1 << i))
+            for (int j = 0; j < 3; ++j) {
+                data.raw_vals[i][j] = readSensor(&rawVals[i][j]);
+                lost |= sensorLost(&rawVals[i][j]);
+                layoutSuspect |= reopened(&rawVals[i][j]);
+            }
+        statTime(timeAccel0 + i, nowNs() - t0);
+    }
+    if (layoutChanged(lost)) {
+        rediscoverIio();
+        return 1;
+    }
+    if (DEBUG) {
+        printf("rawData:");
+        for (int i = 0; i < 4; ++i) for (int j = 0; j < 3; ++j)
+            printf("  %g", data.raw_vals[i][j]);
+        printf("\n");
+    }
+    if (!checkAccels()) return 0;
+    statCount(statAccelRejects);
+    return 1;
+}
+
+int checkAls() {
+    if (fabs(alsData[0] - alsData[1]) > 2000) return 1;
+    return 0;
+}
+
+int read_als() {
+    long long t0 = nowNs();
+    int lost = 0;
+    for (int i = 0; i < maxAls; ++i) {
+        alsData[i] = readSensor(&alsSensors[i]);
+        lost |= sensorLost(&alsSensors[i]);
+        layoutSuspect |= reopened(&alsSensors[i]);
+    }
+    statTime(timeAls, nowNs() - t0);
+    if (layoutChanged(lost)) {
+        rediscoverIio();
+        return 1;
+    }
+    if (!checkAls()) return 0;
+    statCount(statAlsRejects);
+    return 1;
+}
+
+void calculateAverage() {
+    for (int i = 0; i < 2; ++i) for (int j = 0; j < 3; ++j)
+        data.raw_vals[i][j] = (data.raw_vals[i][j] + data.raw_vals[i + 2][j]) / 2.0;
+}
+
+void rotate_keyboard_with_90_deg_over_z() {
+    double temp = data.calculat.cart.keyboard.x;
+    data.calculat.cart.keyboard.x = data.calculat.cart.keyboard.y;
+    data.calculat.cart.keyboard.y = 0.0 - temp;
+}
+
+void convertToPolar() {
+    cart2pol(&data.calculat.cart.screen, &data.calculat.pol.screen);
+    cart2pol(&data.calculat.cart.keyboard, &data.calculat.pol.keyboard);
+}
+
+Debounce orientDb, ffDb;
+LowPass smooth;
+
+Orientation getOrientation() {
+    return classifyOrientationVec((double const *)&data.calculat.cart.screen, orientDb.state);
+}
+
+Formfactor getFormfactor() {
+    return classifyFormfactorVec((double const *)&data.calculat.cart.screen,
+            (double const *)&data.calculat.cart.keyboard, ffDb.state);
+}
+
+Orientation getOrientationPolar() {
+    return classifyOrientation(data.calculat.pol.screen.lat, data.calculat.pol.screen.lon,
+            orientDb.state);
+}
+
+Formfactor getFormfactorPolar() {
+    double relativeTilt = (atan2(data.calculat.cart.screen.z, data.calculat.cart.screen.x) -
+            atan2(data.calculat.cart.keyboard.z, data.calculat.cart.keyboard.x)) * 180.0 / M_PI;
+    if (relativeTilt > 180) relativeTilt -= 360;
+    if (relativeTilt < -180) relativeTilt += 360;
+    return classifyFormfactor(data.calculat.pol.screen.lon, relativeTilt, ffDb.state);
+}
+
+/* the two ALS agree (checkAls), like the accelerometers they are averaged */
+static double wantedBacklight() {
+    double lux = (alsData[0] + alsData[1]) / 2.0;
+    if (lux > 2000000) lux = 2000000;
+    return sqrt(lux / 20000000.0) * 0.85 + 0.15;
+}
+
+/* the state page gives them by value, for readers without decide.h */
+_Static_assert(upward == stateUpward && downward == stateDownward &&
+        leftward == stateLeftward && rightward == stateRightward && horizontal == stateHorizontal &&
+        laptop == stateLaptop && tablet == stateTablet && undefinedFF == stateUndefinedFF &&
+        borderFF == stateBorderFF, "statepage.h and decide.h disagree");
+
+char const *orientName(Orientation o) {
+    return stateOrientName(o);
+}
+
+long long nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Runs a recorded trace through the decision pipeline without touching
+ * any actuator, printing the transitions it would have made. With compare
+ * every sample is also classified from the polar angles and any sample
+ * on which the two classifiers disagree is printed; the exit status is
+ * then 1. */
+static int replay(char const *fn, int compare) {
+    FILE *f = openTraceIn(fn);
+    if (!f) {
+        perror("cannot read trace.");
+        exit(17);
+    }
+    unsigned ms;
+    long samples = 0, rejected = 0, mismatches = 0;
+    Orientation lastOrient = horizontal;
+    Formfactor lastFF = undefinedFF;
+    long long start = nowNs();
+    while (readTrace(f, &ms, data.raw_vals, alsData)) {
+        ++samples;
+        if (checkAccels() || checkAls()) {
+            ++rejected;
+            continue;
+        }
+        calculateAverage();
+        lowPass(&smooth, (double *)data.raw_vals, ms * 1000000LL);
+        rotate_keyboard_with_90_deg_over_z();
+        Orientation o = getOrientation();
+        Formfactor ff = getFormfactor();
+        if (compare) {
+            convertToPolar();
+            Orientation po = getOrientationPolar();
+            Formfactor pff = getFormfactorPolar();
+            if (o != po || ff != pff) {
+                ++mismatches;
+                printf("%10u mismatch %s/%s %s/%s lat %.4f lon %.4f\n", ms, orientName(o),
+                        orientName(po), stateFormName[ff], stateFormName[pff],
+                        data.calculat.pol.screen.lat, data.calculat.pol.screen.lon);
+            }
+        }
+        Orientation newOrient = debounce(&orientDb, o, ms * 1000000LL);
+        Formfactor newFF = debounce(&ffDb, ff, ms * 1000000LL);
+        if (newOrient != horizontal && newOrient != lastOrient)
+            printf("%10u rotate %s\n", ms, orientName(lastOrient = newOrient));
+        if (newFF != undefinedFF && newFF != borderFF && newFF != lastFF)
+            printf("%10u %s\n", ms, stateFormName[lastFF = newFF]);
+    }
+    fclose(f);
+    fprintf(stderr, "%ld samples, %ld rejected, %.0f ns/sample, "
+            "suppressed %ld rotations %ld switches\n", samples, rejected,
+            samples ? (double)(nowNs() - start) / samples : 0.0,
+            orientDb.suppressed, ffDb.suppressed);
+    if (compare) fprintf(stderr, "%ld classifier mismatches\n", mismatches);
+    return mismatches > 0;
+}
+
+#define maxActuators 8
+static Actuator const *active[maxActuators];
+static int nrActive = 0;
+static int useAls = 0;
+
+static void selectActuators(Actuator const *const available[], char const *names) {
+    nrActive = 0;
+    for (int i = 0; available[i] && nrActive < maxActuators; ++i) {
+        if (names) {
+            int len = strlen(available[i]->name);
+            char const *p = names;
+            while ((p = strstr(p, available[i]->name)) &&
+                    !((p == names || p[-1] == ',') && (p[len] == ',' || !p[len]))) p += len;
+            if (!p) continue;
+        }
+        active[nrActive++] = available[i];
+        useAls |= available[i]->needsAls;
+    }
+    if (!nrActive) {
+        fprintf(stderr, "no actuator selected, have:");
+        for (int i = 0; available[i]; ++i) fprintf(stderr, " %s", available[i]->name);
+        fprintf(stderr, "\n");
+        exit(18);
+    }
+}
+
+typedef struct Lane {
+    Actuator const *actuators[maxActuators];
+    int count;
+    Decision posted;
+    Worker worker;
+} Lane;
+static Lane lanes[maxLanes];
+
+static void runLane(void *ctx, void const *job) {
+    Lane *l = ctx;
+    for (int i = 0; i < l->count; ++i) l->actuators[i]->apply(job);
+}
+
+static int inLane(Actuator const *a) {
+    return a->lane > 0 && a->lane < maxLanes;
+}
+
+static void startLanes() {
+    for (int i = 0; i < nrActive; ++i) if (inLane(active[i])) {
+        Lane *l = &lanes[active[i]->lane];
+        l->actuators[l->count++] = active[i];
+    }
+    for (int l = 1; l < maxLanes; ++l) if (lanes[l].count) {
+        lanes[l].posted.orient = lanes[l].posted.ff = -1;
+        startWorker(&lanes[l].worker, runLane, &lanes[l], sizeof(Decision));
+    }
+}
+
+static void postLanes(Decision const *d) {
+    for (int l = 1; l < maxLanes; ++l) {
+        if (!lanes[l].count) continue;
+        if (d->orient == lanes[l].posted.orient && d->ff == lanes[l].posted.ff) {
+            retryJob(&lanes[l].worker);
+            continue;
+        }
+        lanes[l].posted = *d;
+        postJob(&lanes[l].worker, d);
+    }
+}
+
+void refreshLane(int lane) {
+    Lane *l = &lanes[lane];
+    if (!l->count || l->posted.orient == (Orientation)-1) return;
+    l->posted.now = nowNs();
+    postJob(&l->worker, &l->posted);
+}
+
+static void report(Decision const *d) {
+    printf("%10.0f%8.2f%8.2f%10s%10.0f%8.2f%8.2f%6s",
+        data.calculat.pol.screen.alt,
+        data.calculat.pol.screen.lat,
+        data.calculat.pol.screen.lon,
+        orientName(d->orient),
+        data.calculat.pol.keyboard.alt,
+        data.calculat.pol.keyboard.lat,
+        data.calculat.pol.keyboard.lon,
+        stateFormName[d->ff]);
+    if (useAls) printf(" %3.0f", d->backlight * 100);
+    printf("%6ld%6ld\n", orientDb.suppressed, ffDb.suppressed);
+}
+
+static Sched sched;
+static int displayOff = 0, displayWoke = 0;
+
+void setDisplayOff(int off) {
+    if (displayOff == off) return;
+    displayOff = off;
+    if (!off) displayWoke = 1;
+    logAction(logDisplay, off, 0, NULL);
+    kickSched(&sched);
+}
+
+void sampleNow() {
+    kickSched(&sched);
+}
+
+/* A suspend stops CLOCK_MONOTONIC but not CLOCK_BOOTTIME, so a jump in
+ * their difference between two ticks means the device was resumed. */
+static int resumed() {
+    static long long lastGap = -1;
+    struct timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    long long gap = ts.tv_sec * 1000000000LL + ts.tv_nsec - nowNs();
+    int r = lastGap >= 0 && gap - lastGap > 1000000000LL;
+    lastGap = gap;
+    return r;
+}
+
+/* Next to the fake tree under --root, else in the session's runtime dir,
+ * else (ltSwitch started by the system) in yingRunDir; if that cannot be
+ * made, the open says so. */
+static char const *runtimeFile(char fn[PATH_MAX], char const *name) {
+    char const *dir = getenv("XDG_RUNTIME_DIR");
+    if (*sysRoot) snprintf(fn, PATH_MAX, "%s/%s", sysRoot, name);
+    else if (dir && *dir) snprintf(fn, PATH_MAX, "%s/ying-bend-%s", dir, name);
+    else {
+        mkdir(yingRunDir, 0755);
+        snprintf(fn, PATH_MAX, yingRunDir "/%s", name);
+    }
+    return fn;
+}
+
+static int publishing = 0;
+static uint64_t published = 0;
+
+static void publish(Decision const *d) {
+    static Decision last = {0, -1, -1};
+    YingState s;
+    s.orient = d->orient;
+    s.ff = d->ff;
+    memcpy(s.screen, &data.calculat.cart.screen, sizeof(s.screen));
+    memcpy(s.keyboard, &data.calculat.cart.keyboard, sizeof(s.keyboard));
+    s.backlight = useAls ? d->backlight : 0;
+    s.sample = ++published;
+    s.nowNs = d->now;
+    publishState(&s, d->orient != last.orient || d->ff != last.ff);
+    last = *d;
+}
+
+/* next to the fake tree under --root, else in the user's cache dir */
+static char const *defaultIioCache() {
+    static char fn[PATH_MAX];
+    char const *dir = getenv("XDG_CACHE_HOME");
+    if (*sysRoot) snprintf(fn, sizeof(fn), "%s/iio-layout", sysRoot);
+    else if (dir && *dir) snprintf(fn, sizeof(fn), "%s/ying-bend-iio", dir);
+    else if ((dir = getenv("HOME"))) snprintf(fn, sizeof(fn), "%s/.cache/ying-bend-iio", dir);
+    else return NULL;
+    return fn;
+}
+
+/* With -m the screen and keyboard accelerometers wake the loop through
+ * their motion events: each one starts a burst at the fast period that
+ * ends after motionBurstTicks quiet samples, and then the timer stops.
+ * The backlight still needs the ALS read, so with it the timer only falls
+ * back to the idle period. */
+#define motionBurstTicks 8
+
+static int motionWanted = 0, motionOn = 0, quietTicks = 0;
+static int motionFds[2] = {-1, -1};
+static char const *motionThreshold = NULL;
+
+static void onMotion(void *ctx, int fd) {
+    int n = drainIioEvents(fd);
+    if (!n) return;
+    statCountN(statMotionEvents, n);
+    logAction(logMotion, n, 0, NULL);
+    quietTicks = 0;
+    if (!sched.curMs || sched.curMs > sched.fastMs) kickSched(&sched);
+}
+
+static void stopMotion() {
+    for (int i = 0; i < 2; ++i) if (motionFds[i] >= 0) {
+        unwatchFd(motionFds[i]);
+        close(motionFds[i]);
+        motionFds[i] = -1;
+    }
+    motionOn = 0;
+}
+
+/* slots 0 and 1 are the screen and the keyboard; both must have events */
+static void startMotion() {
+    for (int i = 0; i < 2; ++i)
+        if ((motionFds[i] = openIioEvents(layout.accel[i], iioBufs[i].fd, motionThreshold)) < 0) {
+            stopMotion();
+            return;
+        }
+    for (int i = 0; i < 2; ++i) watchFd(motionFds[i], onMotion, NULL, timeMotionHandled, 0);
+    motionOn = 1;
+}
+
+static void restartMotion() {
+    if (!motionWanted) return;
+    stopMotion();
+    startMotion();
+}
+
+long dormantMs = defaultDormantMs;
+static int traceFd = -1, settle = 0;
+static double rawSample[maxDevs][3];
+
+/* the raw values of the tick, before averaging, and how it went */
+static void logSample(long long t0, int flags, Decision const *d) {
+    LogRecord r;
+    r.ns = d ? d->now : t0;
+    r.type = logTick;
+    r.orient = orientDb.state;
+    r.ff = ffDb.state;
+    r.flags = flags;
+    r.value = d && useAls ? lround(d->backlight * 1000) : 0;
+    r.latencyNs = nowNs() - t0;
+    for (int i = 0; i < maxDevs; ++i) for (int j = 0; j < 3; ++j)
+        r.u.raw.accel[i][j] = rawSample[i][j];
+    for (int i = 0; i < maxAls; ++i) r.u.raw.als[i] = alsData[i];
+    writeLog(&r);
+}
+
+/* One sample, from reading the sensors to handing the decision over. */
+static void onTick(void *ctx, int fd) {
+    long long t0 = nowNs();
+    if (ackTick(&sched)) return;
+    int dormant = displayOff;
+    if (displayWoke) {
+        displayWoke = 0;
+        statCount(statDisplayWakes);
+        settle = 1;
+    }
+    if (resumed()) settle = 1;
+    if (dormant) statCount(statDormantTicks);
+    int badData = read_accels();
+    if (useAls && !dormant) badData |= read_als();
+    if (traceFd >= 0) writeTrace(traceFd, data.raw_vals, useAls ? alsData : NULL);
+    memcpy(rawSample, data.raw_vals, sizeof(rawSample));
+    int flags = (dormant ? logDormant : 0) | (settle ? logSettled : 0);
+    if (badData) {
+        logSample(t0, flags | logRejected, NULL);
+        return;
+    }
+    statCount(statSamples);
+    calculateAverage();
+    int moved = sampleMoved(&sched, (double const *)data.raw_vals);
+    Decision d;
+    d.now = nowNs();
+    /* after a gap the old average and candidates say nothing */
+    if (settle) smooth.primed = 0;
+    lowPass(&smooth, (double *)data.raw_vals, d.now);
+    rotate_keyboard_with_90_deg_over_z();
+    if (doRporting) convertToPolar();
+    if (settle) {
+        d.orient = settleDebounce(&orientDb, getOrientation());
+        d.ff = settleDebounce(&ffDb, getFormfactor());
+        settle = 0;
+    } else {
+        d.orient = dormant ? orientDb.state : debounce(&orientDb, getOrientation(), d.now);
+        d.ff = debounce(&ffDb, getFormfactor(), d.now);
+    }
+    d.backlight = wantedBacklight();
+    if (doRporting) report(&d);
+    if (publishing) publish(&d);
+    if (dormant) d.orient = horizontal;
+    for (int i = 0; i < nrActive; ++i) {
+        if (inLane(active[i]) || (dormant && active[i]->needsAls)) continue;
+        active[i]->apply(&d);
+        if (active[i]->busy && active[i]->busy()) moved = 1;
+    }
+    postLanes(&d);
+    logSample(t0, flags, &d);
+    int busyTick = moved || pendingDebounce(&orientDb) || pendingDebounce(&ffDb);
+    quietTicks = busyTick ? 0 : quietTicks + 1;
+    if (motionOn && quietTicks < motionBurstTicks) adaptSched(&sched, 1);
+    else if (motionOn && (dormant || !useAls)) stopSched(&sched);
+    /* a form factor change seen while dormant is confirmed at full rate */
+    else if (dormant && !pendingDebounce(&ffDb)) parkSched(&sched, dormantMs);
+    else adaptSched(&sched, busyTick);
+    /* parked or idle, the trigger would only keep the sensors interrupting */
+    int idle = dormant || !sched.curMs || sched.curMs >= sched.idleMs;
+    for (int i = 0; useIioBuffer && i < maxDevs; ++i) pauseIioBuffer(&iioBufs[i], idle);
+}
+
+int runDaemon(int argc, char *argv[], Actuator const *const available[]) {
+    long fastMs = defaultFastMs, idleMs = defaultIdleMs, dwellMs = defaultDwellMs;
+    int compare = 0;
+    char const *recordFile = NULL, *replayFile = NULL, *actuatorNames = NULL, *statsSock = NULL;
+    char const *stateFile = NULL, *logFile = NULL;
+    char stateDefault[PATH_MAX], logDefault[PATH_MAX];
+    long logRecords = defaultLogRecords;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp("-q", argv[i])) doRporting = 0;
+        else if (!strcmp("-v", argv[i])) doRporting = 1;
+        else if (!strcmp("-b", argv[i])) useIioBuffer = 1;
+        else if (!strcmp("-m", argv[i])) motionWanted = 1;
+        else if (!strcmp("--motion-threshold", argv[i]) && i + 1 < argc)
+            motionThreshold = argv[++i];
+        else if (!strcmp("--xcb", argv[i])) useXcb = 1;
+        else if (!strcmp("-f", argv[i]) && i + 1 < argc) fastMs = atol(argv[++i]);
+        else if (!strcmp("-i", argv[i]) && i + 1 < argc) idleMs = atol(argv[++i]);
+        else if (!strcmp("-d", argv[i]) && i + 1 < argc) dwellMs = atol(argv[++i]);
+        else if (!strcmp("--dormant", argv[i]) && i + 1 < argc) dormantMs = atol(argv[++i]);
+        else if (!strcmp("-a", argv[i]) && i + 1 < argc) actuatorNames = argv[++i];
+        else if (!strcmp("--root", argv[i]) && i + 1 < argc) sysRoot = argv[++i];
+        else if (!strcmp("--record", argv[i]) && i + 1 < argc) recordFile = argv[++i];
+        else if (!strcmp("--replay", argv[i]) && i + 1 < argc) replayFile = argv[++i];
+        else if (!strcmp("--compare", argv[i])) compare = 1;
+        else if (!strcmp("--iio-cache", argv[i]) && i + 1 < argc) iioCacheFile = argv[++i];
+        else if (!strcmp("--stats", argv[i]) && i + 1 < argc) statsSock = argv[++i];
+        else if (!strcmp("--state", argv[i]) && i + 1 < argc) stateFile = argv[++i];
+        else if (!strcmp("--log", argv[i]) && i + 1 < argc) logFile = argv[++i];
+        else if (!strcmp("--log-size", argv[i]) && i + 1 < argc) logRecords = atol(argv[++i]);
+    }
+    initDebounce(&orientDb, horizontal, dwellMs);
+    initDebounce(&ffDb, undefinedFF, dwellMs);
+    if (replayFile) return replay(replayFile, compare);
+    selectActuators(available, actuatorNames);
+    if (!iioCacheFile) iioCacheFile = defaultIioCache();
+    if (!stateFile) stateFile = runtimeFile(stateDefault, "state");
+    if (!logFile) logFile = runtimeFile(logDefault, "log");
+    if (*logFile && openRingLog(logFile, logRecords))
+        fprintf(stderr, "cannot open the log %s: %s, not logging.\n", logFile, strerror(errno));
+    if (*stateFile && !(publishing = !openStatePage(stateFile)))
+        fprintf(stderr, "cannot publish the state in %s: %s, not publishing.\n",
+                stateFile, strerror(errno));
+    /* the actuators may watch fds of their own from init on */
+    initReactor();
+    initStats(statsSock);
+    initSched(&sched, fastMs, idleMs);
+    watchDeadline(&sched.due, onTick, NULL, timeTickHandled);
+    init_accels();
+    if (useAls) init_als();
+    restartMotion();
+    if (motionWanted && !motionOn) fprintf(stderr, "no motion events, sampling on the timer.\n");
+    for (int i = 0; i < nrActive; ++i) if (active[i]->init) active[i]->init();
+    startLanes();
+    if (recordFile && (traceFd = openTraceOut(recordFile)) < 0) {
+        perror("cannot write trace.");
+        exit(17);
+    }
+    runReactor();
+    return 0;
+}
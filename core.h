@@ -0,0 +1,105 @@
+#ifndef CORE_H
+#define CORE_H
+
+#include <limits.h>
+#include "decide.h"
+
+/* The sensor pipeline shared by every front-end: it reads the four
+ * accelerometers (and the ALS when an actuator needs it), decides the
+ * orientation and form factor and hands each sample to the actuators. */
+
+#define DEBUG 0
+
+#define maxName PATH_MAX
+#define maxDevs 4
+#define maxAls 2
+
+typedef struct Cartezian {double x, y, z;} Cartezian;
+typedef struct Polar{double alt, lat, lon;} Polar;
+
+typedef union SensorData {
+    double raw_vals[maxDevs][3];
+    struct {
+        struct { Cartezian screen, keyboard; } cart;
+        struct { Polar screen, keyboard; } pol;
+    } calculat;
+} SensorData;
+
+extern SensorData data;
+extern double alsData[maxAls];
+extern char rawValsFileNames[maxDevs][3][maxName];
+extern char alsRawIllumination[maxAls][maxName];
+extern int doRporting;
+extern int useIioBuffer;
+extern int useXcb;      /* the X actuators talk XCB instead of Xlib */
+extern Debounce orientDb, ffDb;
+
+/* What the pipeline made of one sample. */
+typedef struct Decision {
+    long long now;
+    Orientation orient;
+    Formfactor ff;
+    double backlight;   /* wanted backlight, 0.15..1, from both ALS, only with them read */
+} Decision;
+
+/* An action driven by the decisions. init runs once at startup (may be
+ * NULL), apply after every good sample and must keep its own notion of
+ * what it already did. busy (may be NULL) keeps the sampling fast while
+ * it returns nonzero, for an action that needs fresh samples to finish
+ * (a ramp has a timer of its own instead). Actuators with a nonzero lane
+ * (below maxLanes) that may block run on that lane's worker thread, in
+ * order with the others of the lane, and only see the orientation and
+ * form factor changes; busy is not asked for them. */
+#define maxLanes 4
+
+typedef struct Actuator {
+    char const *name;
+    int needsAls;
+    void (*init)();
+    void (*apply)(Decision const *d);
+    int (*busy)();
+    int lane;
+} Actuator;
+
+/* Hands the lane its last decision again, as of now, e.g. when what its
+ * actuators set was changed behind their back. */
+void refreshLane(int lane);
+
+double readFloat(const char* fn);
+long long nowNs();
+char const *orientName(Orientation o);
+
+void init_accels();
+int checkAccels();
+int read_accels();
+void init_als();
+int checkAls();
+int read_als();
+void calculateAverage();
+void rotate_keyboard_with_90_deg_over_z();
+void convertToPolar();
+Orientation getOrientation();
+Formfactor getFormfactor();
+/* the same decisions from the polar angles, convertToPolar() first */
+Orientation getOrientationPolar();
+Formfactor getFormfactorPolar();
+
+/* Whatever watches the display (the X actuators watch DPMS and the
+ * screen saver) reports it here, from the event loop. While it is off only
+ * the accelerometers are read, every dormantMs, for the form factor; the
+ * actuators that need the ALS are skipped and the lanes get no
+ * orientation. Turning
+ * it back on, or a resume, takes a sample at once and applies it without
+ * the dwell. */
+#define defaultDormantMs 30000
+extern long dormantMs;
+
+void setDisplayOff(int off);
+/* takes a sample at the next turn of the loop */
+void sampleNow();
+
+/* Parses the common options, -a name,... picks from available (NULL
+ * terminated, all of them by default), and runs the sampling loop. */
+int runDaemon(int argc, char *argv[], Actuator const *const available[]);
+
+#endif
@@ -0,0 +1,182 @@
+#include <math.h>
+#include "decide.h"
+
+/* Zones cover an axis in order, each one up to hi. band is how far past
+ * hi the lower zone reaches while it is the current state, and how far
+ * below hi the upper one reaches while that is current. */
+typedef struct Zone {
+    int state;
+    double hi, band;
+} Zone;
+
+#define notHorizontal (-1)
+
+static Zone const latZones[] = {
+    {horizontal, -70, 5},
+    {notHorizontal, 70, 5},
+    {horizontal, INFINITY, 0},
+};
+
+static Zone const lonZones[] = {
+    {upward, -135, 10},
+    {rightward, -45, 10},
+    {downward, 45, 10},
+    {leftward, 135, 10},
+    {upward, INFINITY, 0},
+};
+
+/* -160 with a 10 degree band: a laptop folds to tablet below -170 and
+ * a tablet opens to laptop above -150. */
+static Zone const tiltZones[] = {
+    {tablet, -160, 10},
+    {laptop, -10, 5},
+    {borderFF, 10, 5},
+    {tablet, INFINITY, 0},
+};
+
+#define nrZones(z) (sizeof(z) / sizeof(z[0]))
+
+/* A zone table with its bounds mapped onto the scale it is compared on:
+ * hi as is, lo/hiWide widened by the bands of the zone below and its own. */
+typedef struct Cut {
+    int state;
+    double hi, loWide, hiWide;
+} Cut;
+
+static void cutZones(Zone const *z, int n, double (*scale)(double), Cut *c) {
+    for (int i = 0; i < n; ++i) {
+        c[i].state = z[i].state;
+        c[i].hi = scale(z[i].hi);
+        c[i].loWide = i ? scale(z[i - 1].hi - z[i - 1].band) : -INFINITY;
+        c[i].hiWide = scale(z[i].hi + z[i].band);
+    }
+}
+
+static int inZone(Cut const *c, int i, double v, int widen) {
+    double lo = widen ? c[i].loWide : i ? c[i - 1].hi : -INFINITY;
+    double hi = widen ? c[i].hiWide : c[i].hi;
+    return v > lo && v <= hi;
+}
+
+static int zoneOf(Cut const *c, int n, double v, int current) {
+    for (int i = 0; i < n; ++i)
+        if (c[i].state == current && inZone(c, i, v, 1)) return current;
+    for (int i = 0; i < n; ++i)
+        if (inZone(c, i, v, 0)) return c[i].state;
+    return c[n - 1].state;
+}
+
+/* The vector classifier compares, instead of angles, values that grow
+ * with them and cost no trigonometry: tangent squared (with its sign)
+ * for the latitude and a diamond angle for the longitude and the tilt.
+ * The tables are mapped onto them once, the first time they are used. */
+static double pseudoAngle(double y, double x) {
+    double a = fabs(x) + fabs(y);
+    if (a == 0) return 0;
+    if (x >= 0) return y / a;
+    return y >= 0 ? 2 - y / a : -2 - y / a;
+}
+
+static double degrees(double deg) {
+    return deg;
+}
+
+static double degToPseudo(double deg) {
+    if (isinf(deg)) return deg;
+    return pseudoAngle(sin(deg * M_PI / 180), cos(deg * M_PI / 180));
+}
+
+static double degToTan2(double deg) {
+    if (deg >= 90) return INFINITY;
+    if (deg <= -90) return -INFINITY;
+    double t = tan(deg * M_PI / 180);
+    return t * fabs(t);
+}
+
+#define undefLonLo 80
+#define undefLonHi 100
+
+static struct {
+    int ready;
+    Cut lat[nrZones(latZones)], lon[nrZones(lonZones)], tilt[nrZones(tiltZones)];
+    Cut vecLat[nrZones(latZones)], vecLon[nrZones(lonZones)], vecTilt[nrZones(tiltZones)];
+    double undefLo, undefHi;
+} cuts;
+
+static void initCuts() {
+    cutZones(latZones, nrZones(latZones), degrees, cuts.lat);
+    cutZones(lonZones, nrZones(lonZones), degrees, cuts.lon);
+    cutZones(tiltZones, nrZones(tiltZones), degrees, cuts.tilt);
+    cutZones(latZones, nrZones(latZones), degToTan2, cuts.vecLat);
+    cutZones(lonZones, nrZones(lonZones), degToPseudo, cuts.vecLon);
+    cutZones(tiltZones, nrZones(tiltZones), degToPseudo, cuts.vecTilt);
+    cuts.undefLo = degToPseudo(undefLonLo);
+    cuts.undefHi = degToPseudo(undefLonHi);
+    cuts.ready = 1;
+}
+
+Orientation classifyOrientation(double lat, double lon, Orientation current) {
+    if (!cuts.ready) initCuts();
+    if (horizontal == zoneOf(cuts.lat, nrZones(latZones), lat,
+                current == horizontal ? horizontal : notHorizontal)) return horizontal;
+    return zoneOf(cuts.lon, nrZones(lonZones), lon, current);
+}
+
+Formfactor classifyFormfactor(double lon, double tilt, Formfactor current) {
+    if (!cuts.ready) initCuts();
+    double alon = fabs(lon);
+    if (alon > undefLonLo && alon < undefLonHi) return undefinedFF;
+    return zoneOf(cuts.tilt, nrZones(tiltZones), tilt, current);
+}
+
+Orientation classifyOrientationVec(double const s[3], Orientation current) {
+    if (!cuts.ready) initCuts();
+    double r2 = s[0] * s[0] + s[1] * s[1];
+    double lat = r2 > 0 ? s[2] * fabs(s[2]) / r2 : s[2] > 0 ? INFINITY : s[2] < 0 ? -INFINITY : 0;
+    if (horizontal == zoneOf(cuts.vecLat, nrZones(latZones), lat,
+                current == horizontal ? horizontal : notHorizontal)) return horizontal;
+    return zoneOf(cuts.vecLon, nrZones(lonZones), pseudoAngle(s[1], s[0]), current);
+}
+
+/* the tilt is the angle of the screen from the keyboard in their xz plane */
+Formfactor classifyFormfactorVec(double const s[3], double const k[3], Formfactor current) {
+    if (!cuts.ready) initCuts();
+    double alon = pseudoAngle(fabs(s[1]), s[0]);
+    if (alon > cuts.undefLo && alon < cuts.undefHi) return undefinedFF;
+    double tilt = pseudoAngle(k[0] * s[2] - k[2] * s[0], k[0] * s[0] + k[2] * s[2]);
+    return zoneOf(cuts.vecTilt, nrZones(tiltZones), tilt, current);
+}
+
+void initDebounce(Debounce *d, int state, long dwellMs) {
+    d->state = d->candidate = state;
+    d->since = 0;
+    d->dwellNs = dwellMs * 1000000LL;
+    d->committed = d->suppressed = 0;
+}
+
+int debounce(Debounce *d, int proposed, long long nowNs) {
+    if (proposed != d->candidate) {
+        if (pendingDebounce(d)) ++d->suppressed;
+        d->candidate = proposed;
+        d->since = nowNs;
+    }
+    if (pendingDebounce(d) && nowNs - d->since >= d->dwellNs) {
+        d->state = d->candidate;
+        ++d->committed;
+    }
+    return d->state;
+}
+
+int settleDebounce(Debounce *d, int proposed) {
+    if (proposed != d->state) ++d->committed;
+    d->state = d->candidate = proposed;
+    return d->state;
+}
+
+void lowPass(LowPass *f, double v[6], long long nowNs) {
+    double alpha = 1.0;
+    if (f->primed) alpha = 1.0 - exp(-(double)(nowNs - f->lastNs) / (lowPassTauMs * 1000000.0));
+    for (int i = 0; i < 6; ++i) v[i] = f->v[i] += alpha * (v[i] - f->v[i]);
+    f->primed = 1;
+    f->lastNs = nowNs;
+}
@@ -0,0 +1,51 @@
+#ifndef DECIDE_H
+#define DECIDE_H
+
+#include <X11/extensions/randr.h>
+
+typedef enum Orientation {horizontal = 0,
+    upward = RR_Rotate_270, downward = RR_Rotate_90,
+    leftward = RR_Rotate_180, rightward = RR_Rotate_0} Orientation;
+typedef enum Formfactor {laptop, tablet, undefinedFF, borderFF} Formfactor;
+
+/* Classification of one sample against the shared threshold tables.
+ * The zone of the current state is widened by its hysteresis bands, so
+ * a sample sitting on a boundary does not flip the decision back and
+ * forth. Angles are in degrees, tilt is the screen/keyboard angle. */
+Orientation classifyOrientation(double lat, double lon, Orientation current);
+Formfactor classifyFormfactor(double lon, double tilt, Formfactor current);
+/* The same decisions straight from the averaged screen (s) and keyboard
+ * (k) vectors, without trigonometry. */
+Orientation classifyOrientationVec(double const s[3], Orientation current);
+Formfactor classifyFormfactorVec(double const s[3], double const k[3], Formfactor current);
+
+/* A new state is committed only after it has been proposed for dwellNs
+ * without interruption; candidates given up before that are counted as
+ * suppressed transitions. */
+typedef struct Debounce {
+    int state, candidate;
+    long long since, dwellNs;
+    long committed, suppressed;
+} Debounce;
+
+#define defaultDwellMs 500
+
+void initDebounce(Debounce *d, int state, long dwellMs);
+int debounce(Debounce *d, int proposed, long long nowNs);
+/* commits proposed at once, for the first sample after a long gap */
+int settleDebounce(Debounce *d, int proposed);
+#define pendingDebounce(d) ((d)->candidate != (d)->state)
+
+/* First order low-pass over the averaged screen and keyboard vectors,
+ * with a time constant so a slow tick is not lagged more than a fast one. */
+typedef struct LowPass {
+    int primed;
+    long long lastNs;
+    double v[6];
+} LowPass;
+
+#define lowPassTauMs 150
+
+void lowPass(LowPass *f, double v[6], long long nowNs);
+
+#endif
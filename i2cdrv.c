@@ -0,0 +1,153 @@
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include "sensor.h"
+#include "core.h"
+#include "actuators.h"
+#include "stats.h"
+#include "worker.h"
+#include "uevent.h"
+#include "reactor.h"
+#include "ringlog.h"
+
+#define GOODIX_DEV "i2c-GDIX1001:00"
+#define GOODIX_DRV_PATH "/sys/bus/i2c/drivers/Goodix-TS"
+#define WACOM_DEV "i2c-WCOM0019:00"
+#define WACOM_DRV_PATH "/sys/bus/i2c/drivers/i2c_hid"
+
+static enum {activateKeyboard, activatePen} whatToActivate = activateKeyboard;
+
+/* returns nonzero if all of text was written */
+static int writeText(char const * const text, char const * const file) {
+    char path[PATH_MAX];
+    if (sysPath(path, PATH_MAX, "%s", file)) return 0;
+    long long t0 = nowNs();
+    int f = open(path, O_WRONLY);
+    if (f < 0) return 0;
+    int r = write(f, text, strlen(text));
+    statTime(timeDriverBind, nowNs() - t0);
+    close(f);
+    return r == (int)strlen(text);
+}
+
+static int exists(char const * const dirName) {
+    char path[PATH_MAX];
+    if (sysPath(path, PATH_MAX, "%s", dirName)) return 0;
+    DIR *isActiveDir = opendir(path);
+    if (isActiveDir) {
+        closedir(isActiveDir);
+        return 1;
+    }
+    return 0;
+}
+
+/* Each device binds and unbinds on its own worker, so the kernel probing
+ * one does not hold up the other; the last state asked for wins. Whether
+ * it is bound is cached and kept current from the bind/unbind/add/remove
+ * uevents, read on the event loop, so deciding costs no filesystem
+ * probing; without the uevent socket the driver directory is looked at
+ * instead. */
+typedef struct I2cDev {
+    char const *dev, *drvPath;
+    int wanted;
+    atomic_int bound;
+    Worker worker;
+} I2cDev;
+
+enum {goodix, wacom, nrI2cDevs};
+static I2cDev i2cDevs[nrI2cDevs] = {{GOODIX_DEV, GOODIX_DRV_PATH}, {WACOM_DEV, WACOM_DRV_PATH}};
+static int ueventFd = -1;
+
+typedef struct BindJob {
+    int bind;
+    long long since;
+} BindJob;
+
+static int devExists(I2cDev const *d) {
+    char file[PATH_MAX];
+    snprintf(file, PATH_MAX, "%s/%s", d->drvPath, d->dev);
+    return exists(file);
+}
+
+static int cachedBound(I2cDev *d) {
+    if (ueventFd < 0) return devExists(d);
+    return atomic_load_explicit(&d->bound, memory_order_relaxed);
+}
+
+static void runBind(void *ctx, void const *job) {
+    I2cDev *d = ctx;
+    BindJob const *j = job;
+    char file[PATH_MAX];
+    if (j->bind == cachedBound(d)) return;
+    snprintf(file, PATH_MAX, "%s/%s", d->drvPath, j->bind ? "bind" : "unbind");
+    /* the uevent confirms it too, but may be behind the next decision */
+    int ok = writeText(d->dev, file);
+    if (ok) atomic_store(&d->bound, j->bind);
+    long long took = nowNs() - j->since;
+    statTime(timeDriverDone, took);
+    logAction(logBind, ok ? j->bind : -1, took, d->dev);
+}
+
+/* while a change is on its way, the state asked for is the one to go by */
+static int isBound(I2cDev *d) {
+    return workerIdle(&d->worker) ? cachedBound(d) : d->wanted;
+}
+
+static void want(I2cDev *d, int bind, long long since) {
+    BindJob j = {bind, since};
+    if (isBound(d) == bind) return;
+    d->wanted = bind;
+    postJob(&d->worker, &j);
+}
+
+static void resyncDrivers() {
+    for (int i = 0; i < nrI2cDevs; ++i) atomic_store(&i2cDevs[i].bound, devExists(&i2cDevs[i]));
+}
+
+static void onUevents(void *ctx, int fd) {
+    char buf[ueventBufSize];
+    Uevent ev;
+    int r;
+    while ((r = readUevent(fd, buf, &ev)) >= 0 || errno == ENOBUFS) {
+        if (r < 0) resyncDrivers();
+        if (r <= 0) continue;
+        for (int i = 0; i < nrI2cDevs; ++i) {
+            if (strcmp(ueventDevice(&ev), i2cDevs[i].dev)) continue;
+            if (!strcmp(ev.action, "bind")) atomic_store(&i2cDevs[i].bound, 1);
+            else if (!strcmp(ev.action, "unbind") || !strcmp(ev.action, "remove") ||
+                    !strcmp(ev.action, "add")) atomic_store(&i2cDevs[i].bound, 0);
+            statCount(statDriverUevents);
+            logAction(logUevent, atomic_load(&i2cDevs[i].bound), 0, i2cDevs[i].dev);
+        }
+    }
+}
+
+static void initDrivers() {
+    /* listen first, so no change falls between the probe and the socket */
+    ueventFd = openUevents();
+    resyncDrivers();
+    if (ueventFd >= 0) watchFd(ueventFd, onUevents, NULL, timeUeventHandled, 0);
+    else perror("no uevents, probing the drivers instead");
+    for (int i = 0; i < nrI2cDevs; ++i)
+        startWorker(&i2cDevs[i].worker, runBind, &i2cDevs[i], sizeof(BindJob));
+}
+
+/* In tablet mode both the halo keyboard (Goodix) and the pen (Wacom)
+ * are unbound; opening to laptop brings back whichever was in use. */
+static void applyDrivers(Decision const *d) {
+    for (int i = 0; i < nrI2cDevs; ++i) retryJob(&i2cDevs[i].worker);
+    if (d->ff == undefinedFF || d->ff == borderFF) return;
+    if (laptop == d->ff) {
+        if (!isBound(&i2cDevs[wacom]) && !isBound(&i2cDevs[goodix]))
+            want(&i2cDevs[activateKeyboard == whatToActivate ? goodix : wacom], 1, d->now);
+    } else {
+        whatToActivate = isBound(&i2cDevs[wacom]) ? activatePen : activateKeyboard;
+        want(&i2cDevs[goodix], 0, d->now);
+        want(&i2cDevs[wacom], 0, d->now);
+    }
+}
+
+Actuator const driversActuator = {"drivers", 0, initDrivers, applyDrivers, NULL, driversLane};
@@ -0,0 +1,276 @@
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/iio/events.h>
+#include "iiobuf.h"
+#include "sensor.h"
+
+#define IIO_SYSFS "/sys/bus/iio/devices/iio:device%d/%s"
+#define IIO_BUF_LEN 16
+#define iioFreshNs 20000000LL
+#define iioWaitMs 20
+
+static int attrPath(char *path, int size, int devNr, char const *attr) {
+    return sysPath(path, size, IIO_SYSFS, devNr, attr) ? -1 : 0;
+}
+
+static int writeAttr(int devNr, char const *attr, char const *val) {
+    char path[256];
+    if (attrPath(path, sizeof(path), devNr, attr)) return -1;
+    int f = open(path, O_WRONLY);
+    if (f < 0) return -1;
+    int r = write(f, val, strlen(val));
+    close(f);
+    return r < 0 ? -1 : 0;
+}
+
+static int readAttr(int devNr, char const *attr, char *val, int size) {
+    char path[256];
+    if (attrPath(path, sizeof(path), devNr, attr)) return -1;
+    int f = open(path, O_RDONLY);
+    if (f < 0) return -1;
+    int r = read(f, val, size - 1);
+    close(f);
+    if (r < 0) return -1;
+    while (r > 0 && (val[r - 1] == '\n' || val[r - 1] == ' ')) --r;
+    val[r] = 0;
+    return r;
+}
+
+/* "le:s12/16>>4" as described in Documentation/ABI/testing/sysfs-bus-iio */
+static int parseType(char const *type, IioChannel *c) {
+    char endian[3], sign;
+    int repeat, n = 0;
+    c->shift = 0;
+    if (sscanf(type, "%2[bl]e:%c%d/%d%n", endian, &sign,
+                &c->bits, &c->storage, &n) < 4) return -1;
+    type += n;
+    if (*type == 'X' && sscanf(type, "X%d%n", &repeat, &n) == 1) type += n;
+    sscanf(type, ">>%d", &c->shift);
+    c->bigEndian = endian[0] == 'b';
+    c->isSigned = sign == 's' || sign == 'S';
+    if (c->storage != 8 && c->storage != 16 && c->storage != 32 && c->storage != 64) return -1;
+    return 0;
+}
+
+static int setupChannel(int devNr, char const *name, IioChannel *c) {
+    char attr[64], val[32];
+    snprintf(attr, sizeof(attr), "scan_elements/%s_en", name);
+    if (writeAttr(devNr, attr, "1")) return -1;
+    snprintf(attr, sizeof(attr), "scan_elements/%s_index", name);
+    if (readAttr(devNr, attr, val, sizeof(val)) <= 0) return -1;
+    c->index = 0;
+    sscanf(val, "%d", &c->index);
+    snprintf(attr, sizeof(attr), "scan_elements/%s_type", name);
+    if (readAttr(devNr, attr, val, sizeof(val)) <= 0) return -1;
+    return parseType(val, c);
+}
+
+/* Channels are packed in scan index order, each aligned to its own size. */
+static int layoutScan(IioBuffer *b) {
+    int done[iioChannels] = {0};
+    int offset = 0, maxAlign = 1;
+    for (int n = 0; n < iioChannels; ++n) {
+        int next = -1;
+        for (int i = 0; i < iioChannels; ++i)
+            if (!done[i] && (next < 0 || b->chan[i].index < b->chan[next].index)) next = i;
+        int bytes = b->chan[next].storage / 8;
+        offset = (offset + bytes - 1) / bytes * bytes;
+        b->chan[next].offset = offset;
+        offset += bytes;
+        if (bytes > maxAlign) maxAlign = bytes;
+        done[next] = 1;
+    }
+    b->scanSize = (offset + maxAlign - 1) / maxAlign * maxAlign;
+    return b->scanSize;
+}
+
+int openIioBuffer(IioBuffer *b, int devNr) {
+    static char const *names[iioChannels] = {"in_accel_x", "in_accel_y", "in_accel_z", "in_timestamp"};
+    char val[64], trig[96], dev[256];
+    b->fd = -1;
+    b->devNr = devNr;
+    b->timestamp = 0;
+    b->paused = 0;
+    writeAttr(devNr, "buffer/enable", "0");
+    for (int i = 0; i < iioChannels; ++i)
+        if (setupChannel(devNr, names[i], &b->chan[i])) return -1;
+    layoutScan(b);
+    /* so the scan timestamps compare with the tick */
+    b->clock = writeAttr(devNr, "current_timestamp_clock", "monotonic") ?
+        CLOCK_REALTIME : CLOCK_MONOTONIC;
+    if (readAttr(devNr, "trigger/current_trigger", val, sizeof(val)) <= 0) {
+        /* drivers name their data ready trigger "<name>-dev<N>" */
+        if (readAttr(devNr, "name", val, sizeof(val)) <= 0) return -1;
+        snprintf(trig, sizeof(trig), "%s-dev%d", val, devNr);
+        if (writeAttr(devNr, "trigger/current_trigger", trig)) return -1;
+    }
+    snprintf(val, sizeof(val), "%d", IIO_BUF_LEN);
+    if (writeAttr(devNr, "buffer/length", val)) return -1;
+    if (writeAttr(devNr, "buffer/enable", "1")) return -1;
+    if (sysPath(dev, sizeof(dev), "/dev/iio:device%d", devNr)) return -1;
+    b->fd = open(dev, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (b->fd < 0) {
+        writeAttr(devNr, "buffer/enable", "0");
+        return -1;
+    }
+    return 0;
+}
+
+void closeIioBuffer(IioBuffer *b) {
+    if (b->fd < 0) return;
+    close(b->fd);
+    b->fd = -1;
+    writeAttr(b->devNr, "buffer/enable", "0");
+}
+
+static long long decode(unsigned char const *scan, IioChannel const *c) {
+    int bytes = c->storage / 8;
+    unsigned long long v = 0;
+    for (int i = 0; i < bytes; ++i)
+        v |= (unsigned long long)scan[c->offset + i] <<
+            8 * (c->bigEndian ? bytes - 1 - i : i);
+    v >>= c->shift;
+    if (c->bits < 64) {
+        v &= (1ULL << c->bits) - 1;
+        if (c->isSigned && (v >> (c->bits - 1)) & 1) v |= ~0ULL << c->bits;
+    }
+    return (long long)v;
+}
+
+static long long clockNs(int clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Reads every scan waiting and keeps the newest; nonzero if there was one. */
+static int drainScans(IioBuffer *b) {
+    unsigned char buf[IIO_BUF_LEN * 64];
+    int got = 0, r;
+    while ((r = read(b->fd, buf, b->scanSize * IIO_BUF_LEN)) >= b->scanSize) {
+        unsigned char const *scan = buf + (r / b->scanSize - 1) * b->scanSize;
+        for (int i = 0; i < 3; ++i) b->last[i] = decode(scan, &b->chan[i]);
+        b->timestamp = decode(scan, &b->chan[iioTimestamp]);
+        got = 1;
+    }
+    return got;
+}
+
+static int fresh(IioBuffer const *b) {
+    return b->timestamp && clockNs(b->clock) - b->timestamp <= iioFreshNs;
+}
+
+/* The trigger runs at the sensor's rate between ticks and a full kfifo
+ * drops the new scans, so what is waiting may be from long before the
+ * tick. The buffers without a scan younger than iioFreshNs are waited
+ * for together, iioWaitMs in all, so a tick never blocks longer than that
+ * whatever the number of devices. */
+int readIioScans(IioBuffer *b, int n, double xyz[][3]) {
+    struct pollfd p[32];
+    int idx[32], np = 0, got = 0;
+    for (int i = 0; i < n && i < 32; ++i) {
+        if (b[i].fd < 0 || b[i].paused) continue;
+        drainScans(&b[i]);
+        if (fresh(&b[i])) got |= 1 << i;
+        else {
+            p[np] = (struct pollfd){b[i].fd, POLLIN, 0};
+            idx[np++] = i;
+        }
+    }
+    long long until = clockNs(CLOCK_MONOTONIC) + iioWaitMs * 1000000LL;
+    while (np) {
+        long long left = until - clockNs(CLOCK_MONOTONIC);
+        if (left <= 0 || poll(p, np, (left + 999999) / 1000000) <= 0) break;
+        for (int j = 0; j < np; ++j) {
+            if (!(p[j].revents & POLLIN) || !drainScans(&b[idx[j]])) continue;
+            got |= 1 << idx[j];
+            p[j] = p[--np];
+            idx[j--] = idx[np];
+        }
+    }
+    for (int i = 0; i < n && i < 32; ++i)
+        if (got & 1 << i) memcpy(xyz[i], b[i].last, sizeof(b[i].last));
+    return got;
+}
+
+void pauseIioBuffer(IioBuffer *b, int paused) {
+    if (b->fd < 0 || b->paused == paused) return;
+    b->paused = paused;
+    b->timestamp = 0;
+    writeAttr(b->devNr, "buffer/enable", paused ? "0" : "1");
+}
+
+static int endsWith(char const *s, int len, char const *suffix) {
+    int n = strlen(suffix);
+    return len >= n && !strcmp(s + len - n, suffix);
+}
+
+/* Every accelerometer event the driver has (thresh, roc, mag...) is
+ * turned on, whatever its direction: bmc150-accel only has
+ * roc_either, others only rising. threshold goes to its _value if given. */
+static int enableMotionEvents(int devNr, char const *threshold) {
+    char dir[256], attr[320];
+    int enabled = 0;
+    if (attrPath(dir, sizeof(dir), devNr, "events")) return 0;
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        int len = strlen(e->d_name);
+        if (strncmp(e->d_name, "in_accel", 8) || len + 16 > (int)sizeof(attr) ||
+                !(endsWith(e->d_name, len, "_rising_en") || endsWith(e->d_name, len, "_falling_en") ||
+                endsWith(e->d_name, len, "_either_en"))) continue;
+        if (threshold) {
+            snprintf(attr, sizeof(attr), "events/%.*s_value", len - 3, e->d_name);
+            writeAttr(devNr, attr, threshold);
+        }
+        snprintf(attr, sizeof(attr), "events/%s", e->d_name);
+        if (!writeAttr(devNr, attr, "1")) ++enabled;
+    }
+    closedir(d);
+    return enabled;
+}
+
+int openIioEvents(int devNr, int chrFd, char const *threshold) {
+    char dev[256];
+    int evFd = -1;
+    if (!enableMotionEvents(devNr, threshold)) return -1;
+    if (*sysRoot) {
+        struct sockaddr_un addr = {AF_UNIX};
+        if (sysPath(addr.sun_path, sizeof(addr.sun_path), "/dev/iio:device%d-events", devNr))
+            return -1;
+        evFd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(addr.sun_path);
+        if (evFd >= 0 && bind(evFd, (struct sockaddr *)&addr, sizeof(addr))) {
+            close(evFd);
+            return -1;
+        }
+        return evFd;
+    }
+    /* the character device opens only once, so a buffer's fd is reused */
+    int fd = chrFd;
+    if (fd < 0) {
+        if (sysPath(dev, sizeof(dev), "/dev/iio:device%d", devNr)) return -1;
+        if ((fd = open(dev, O_RDONLY | O_CLOEXEC)) < 0) return -1;
+    }
+    if (ioctl(fd, IIO_GET_EVENT_FD_IOCTL, &evFd) < 0) evFd = -1;
+    if (fd != chrFd) close(fd);
+    if (evFd >= 0) fcntl(evFd, F_SETFL, fcntl(evFd, F_GETFL) | O_NONBLOCK);
+    return evFd;
+}
+
+int drainIioEvents(int fd) {
+    struct iio_event_data ev[8];
+    int n = 0, r;
+    while ((r = read(fd, ev, sizeof(ev))) >= (int)sizeof(ev[0])) n += r / sizeof(ev[0]);
+    return n;
+}
@@ -0,0 +1,50 @@
+#ifndef IIOBUF_H
+#define IIOBUF_H
+
+/* Buffered capture of an IIO accelerometer: x, y, z and the timestamp
+ * are latched together by the trigger and come out of /dev/iio:deviceN
+ * as one packed scan, so a whole sample costs one read(). */
+
+typedef struct IioChannel {
+    int index;      /* scan index, decides the order in the scan */
+    int offset;     /* byte offset inside the scan */
+    int storage;    /* storage bits */
+    int bits;       /* real bits */
+    int shift;
+    int isSigned;
+    int bigEndian;
+} IioChannel;
+
+enum {iioX, iioY, iioZ, iioTimestamp, iioChannels};
+
+typedef struct IioBuffer {
+    int fd;
+    int devNr;
+    int scanSize;
+    IioChannel chan[iioChannels];
+    long long timestamp;    /* of the last decoded scan, in ns, 0 if none yet */
+    int clock;              /* the one the timestamps are on */
+    int paused;             /* buffer disabled, the trigger off, read sysfs */
+    double last[3];
+} IioBuffer;
+
+int openIioBuffer(IioBuffer *b, int devNr);
+/* Sets xyz[i] from a fresh scan of b[i] for each bit of the mask it
+ * returns, waiting a little for them all at once if need be; the others,
+ * and the paused ones, are for sysfs. */
+int readIioScans(IioBuffer *b, int n, double xyz[][3]);
+/* Turns the trigger off while nothing samples fast, so the sensors stop
+ * interrupting at their data rate; paused buffers read as missing. */
+void pauseIioBuffer(IioBuffer *b, int paused);
+void closeIioBuffer(IioBuffer *b);
+
+/* Motion events: turns on the threshold/roc/mag events of the
+ * device and returns the fd they come out of, -1 if it has none. chrFd is
+ * the open /dev/iio:deviceN, or -1. Under a --root tree the fd is the
+ * datagram socket <root>/dev/iio:deviceN-events instead, where anything
+ * can send struct iio_event_data records. */
+int openIioEvents(int devNr, int chrFd, char const *threshold);
+/* reads all the events waiting, returns how many */
+int drainIioEvents(int fd);
+
+#endif
@@ -0,0 +1,200 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <limits.h>
+#include "sensor.h"
+#include "iiodisc.h"
+
+char const *iioCacheFile = NULL;
+
+enum {kindNone, kindAccel, kindAls};
+static char const *kindNames[] = {"none", "accel", "als"};
+
+typedef struct IioEntry {
+    int kind, slot, nr;
+    IioKey key;
+} IioEntry;
+
+#define maxIioDevs 32
+
+/* reads a short attribute with the whitespace squeezed out, "-" if missing */
+static void readWord(int nr, char const *attr, char *buf, int size) {
+    char path[PATH_MAX];
+    FILE *f = NULL;
+    int n = 0, c;
+    if (!sysPath(path, PATH_MAX, "/sys/bus/iio/devices/iio:device%d/%s", nr, attr))
+        f = fopen(path, "r");
+    if (f) {
+        while ((c = fgetc(f)) != EOF && n < size - 1) if (c > ' ') buf[n++] = c;
+        fclose(f);
+    }
+    if (!n) buf[n++] = '-';
+    buf[n] = 0;
+}
+
+static void readKey(int nr, IioKey *k) {
+    char path[PATH_MAX], link[PATH_MAX];
+    readWord(nr, "name", k->name, sizeof(k->name));
+    readWord(nr, "in_accel_mount_matrix", k->matrix, sizeof(k->matrix));
+    if (!strcmp(k->matrix, "-")) readWord(nr, "mount_matrix", k->matrix, sizeof(k->matrix));
+    strcpy(k->parent, "-");
+    if (sysPath(path, PATH_MAX, "/sys/bus/iio/devices/iio:device%d", nr)) return;
+    int n = readlink(path, link, sizeof(link) - 1);
+    if (n <= 0) return;
+    link[n] = 0;
+    char *dev = strrchr(link, '/');
+    if (!dev) return;
+    *dev = 0;
+    char *parent = strrchr(link, '/');
+    snprintf(k->parent, sizeof(k->parent), "%.63s", parent ? parent + 1 : link);
+}
+
+static int sameKey(IioKey const *a, IioKey const *b) {
+    return !strcmp(a->name, b->name) && !strcmp(a->parent, b->parent) &&
+        !strcmp(a->matrix, b->matrix);
+}
+
+static int hasAttr(int nr, char const *attr) {
+    char path[PATH_MAX];
+    return !sysPath(path, PATH_MAX, "/sys/bus/iio/devices/iio:device%d/%s", nr, attr) &&
+        !access(path, R_OK);
+}
+
+static int kindOf(int nr) {
+    if (hasAttr(nr, "in_accel_x_raw")) return kindAccel;
+    if (hasAttr(nr, "in_illuminance_raw")) return kindAls;
+    return kindNone;
+}
+
+static int slotsOf(int kind) {
+    return kind == kindAccel ? iioAccelSlots : iioAlsSlots;
+}
+
+static int *slotRef(IioLayout *l, int kind, int slot) {
+    return kind == kindAccel ? &l->accel[slot] : &l->als[slot];
+}
+
+static void place(IioLayout *l, IioEntry const *e) {
+    *slotRef(l, e->kind, e->slot) = e->nr;
+    (e->kind == kindAccel ? l->accelKey : l->alsKey)[e->slot] = e->key;
+}
+
+static int loadCache(IioEntry *e) {
+    int n = 0;
+    char kind[8];
+    FILE *f = iioCacheFile && *iioCacheFile ? fopen(iioCacheFile, "r") : NULL;
+    if (!f) return 0;
+    while (n < maxIioDevs && fscanf(f, "%7s %d %d %31s %63s %95s", kind, &e[n].slot, &e[n].nr,
+                e[n].key.name, e[n].key.parent, e[n].key.matrix) == 6) {
+        e[n].kind = !strcmp(kind, "accel") ? kindAccel : !strcmp(kind, "als") ? kindAls : kindNone;
+        if (e[n].kind != kindNone && e[n].slot >= 0 && e[n].slot < slotsOf(e[n].kind)) ++n;
+    }
+    fclose(f);
+    return n;
+}
+
+static void saveCache(IioEntry const *e, int n) {
+    char tmp[PATH_MAX];
+    if (!iioCacheFile || !*iioCacheFile) return;
+    snprintf(tmp, sizeof(tmp), "%s.new", iioCacheFile);
+    FILE *f = fopen(tmp, "w");
+    if (!f) return;
+    for (int i = 0; i < n; ++i) fprintf(f, "%s %d %d %s %s %s\n", kindNames[e[i].kind],
+            e[i].slot, e[i].nr, e[i].key.name, e[i].key.parent, e[i].key.matrix);
+    if (fclose(f) || rename(tmp, iioCacheFile)) unlink(tmp);
+}
+
+static int complete(IioLayout const *l) {
+    for (int i = 0; i < iioAccelSlots; ++i) if (l->accel[i] < 0) return 0;
+    for (int i = 0; i < iioAlsSlots; ++i) if (l->als[i] < 0) return 0;
+    return 1;
+}
+
+/* The driver names the half an accelerometer is in, when the firmware
+ * says (bmc150 and kxcjk-1013 on the dual ACPI ones): "accel-display" or
+ * "accel-base". 0 for the screen, 1 for the keyboard, as the slots
+ * alternate, -1 if there is no label. */
+static int halfOf(int nr) {
+    char label[32];
+    readWord(nr, "label", label, sizeof(label));
+    if (strstr(label, "display")) return 0;
+    if (strstr(label, "base")) return 1;
+    return -1;
+}
+
+static int compareNr(void const *a, void const *b) {
+    return ((IioEntry const *)a)->nr - ((IioEntry const *)b)->nr;
+}
+
+int discoverIio(IioLayout *l, int rescan) {
+    IioEntry cached[maxIioDevs], found[maxIioDevs];
+    int nCached = loadCache(cached), nFound = 0;
+    memset(l, -1, sizeof(*l));
+
+    /* the cached devices still where they were: no directory scan */
+    int stale = rescan || !nCached;
+    for (int i = 0; i < nCached && !stale; ++i) {
+        IioKey k;
+        readKey(cached[i].nr, &k);
+        if (!sameKey(&k, &cached[i].key) || kindOf(cached[i].nr) != cached[i].kind) stale = 1;
+        else place(l, &cached[i]);
+    }
+    if (!stale) return !complete(l);
+
+    char path[PATH_MAX];
+    if (sysPath(path, PATH_MAX, "/sys/bus/iio/devices")) return 1;
+    DIR *dir = opendir(path);
+    if (!dir) return 1;
+    struct dirent *de;
+    while ((de = readdir(dir)) && nFound < maxIioDevs) {
+        int nr;
+        if (sscanf(de->d_name, "iio:device%d", &nr) != 1) continue;
+        found[nFound].nr = nr;
+        found[nFound].slot = -1;
+        if ((found[nFound].kind = kindOf(nr)) == kindNone) continue;
+        readKey(nr, &found[nFound++].key);
+    }
+    closedir(dir);
+    qsort(found, nFound, sizeof(found[0]), compareNr);
+
+    /* known devices keep their slot whatever their index, the others
+     * fill the free slots, those with a label first, in index order */
+    memset(l, -1, sizeof(*l));
+    for (int i = 0; i < nCached; ++i) for (int j = 0; j < nFound; ++j)
+        if (found[j].slot < 0 && found[j].kind == cached[i].kind &&
+                *slotRef(l, cached[i].kind, cached[i].slot) < 0 &&
+                sameKey(&found[j].key, &cached[i].key)) {
+            found[j].slot = cached[i].slot;
+            place(l, &found[j]);
+        }
+    for (int labelled = 1; labelled >= 0; --labelled) for (int j = 0; j < nFound; ++j) {
+        int half = found[j].kind == kindAccel ? halfOf(found[j].nr) : -1;
+        if ((half >= 0) != labelled) continue;
+        for (int s = 0; found[j].slot < 0 && s < slotsOf(found[j].kind); ++s)
+            if (*slotRef(l, found[j].kind, s) < 0 && (half < 0 || s % 2 == half)) {
+                found[j].slot = s;
+                place(l, &found[j]);
+            }
+    }
+
+    IioEntry keep[maxIioDevs];
+    int nKeep = 0;
+    for (int j = 0; j < nFound; ++j) if (found[j].slot >= 0) keep[nKeep++] = found[j];
+    if (nKeep) saveCache(keep, nKeep);
+    return !complete(l);
+}
+
+int iioLayoutMoved(IioLayout const *l) {
+    IioKey k;
+    for (int i = 0; i < iioAccelSlots; ++i) if (l->accel[i] >= 0) {
+        readKey(l->accel[i], &k);
+        if (!sameKey(&k, &l->accelKey[i]) || kindOf(l->accel[i]) != kindAccel) return 1;
+    }
+    for (int i = 0; i < iioAlsSlots; ++i) if (l->als[i] >= 0) {
+        readKey(l->als[i], &k);
+        if (!sameKey(&k, &l->alsKey[i]) || kindOf(l->als[i]) != kindAls) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef IIODISC_H
+#define IIODISC_H
+
+/* Finds the accelerometers and light sensors with one readdir of
+ * /sys/bus/iio/devices. A device is known by its name, the device it
+ * hangs off (e.g. i2c-BOSC0200:00) and its mount matrix, which stay the
+ * same when the iio:deviceN index does not. The layout found is kept in
+ * a cache file, one line per slot:
+ *     accel <slot> <N> <name> <parent> <matrix>
+ * so the next start only checks those devices. The accelerometer slots
+ * are screen, keyboard, screen, keyboard; the first discovery puts a
+ * device whose label says accel-display or accel-base in a slot of its
+ * half and fills the rest in index order. The file can be edited to say
+ * otherwise. */
+#define iioAccelSlots 4
+#define iioAlsSlots 2
+
+typedef struct IioKey {
+    char name[32], parent[64], matrix[96];
+} IioKey;
+
+typedef struct IioLayout {
+    int accel[iioAccelSlots];   /* iio:deviceN, -1 when not found */
+    int als[iioAlsSlots];
+    IioKey accelKey[iioAccelSlots], alsKey[iioAlsSlots];   /* what was found there */
+} IioLayout;
+
+/* NULL or "" for no cache */
+extern char const *iioCacheFile;
+
+/* Returns nonzero when some slot stayed empty. Without rescan a cache
+ * whose devices all check out is taken as it is. */
+int discoverIio(IioLayout *l, int rescan);
+/* Nonzero when a device of the layout is not the one found there any
+ * more, e.g. two indexes swapped by a driver reload: a sensor that was
+ * reopened fine may then be reading the other half. */
+int iioLayoutMoved(IioLayout const *l);
+
+#endif
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "core.h"
+#include "reactor.h"
+
+typedef struct Watch {
+    int fd;
+    FdHandler handler;
+    void *ctx;
+    enum StatTimer timer;
+} Watch;
+
+static Watch watches[maxWatches];
+static int epollFd = -1;
+static long long const *deadline = NULL;
+static Watch onDeadline;
+
+void initReactor() {
+    for (int i = 0; i < maxWatches; ++i) watches[i].fd = -1;
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        perror("cannot create the event loop.");
+        exit(20);
+    }
+}
+
+void watchFd(int fd, FdHandler h, void *ctx, enum StatTimer t, int edge) {
+    Watch *w = NULL;
+    for (int i = 0; i < maxWatches && !w; ++i) if (watches[i].fd < 0) w = &watches[i];
+    if (!w) {
+        fprintf(stderr, "too many fds to watch.\n");
+        exit(20);
+    }
+    struct epoll_event ev = {EPOLLIN | (edge ? EPOLLET : 0), {.ptr = w}};
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev)) {
+        perror("cannot watch fd.");
+        exit(20);
+    }
+    w->fd = fd;
+    w->handler = h;
+    w->ctx = ctx;
+    w->timer = t;
+}
+
+/* a later event of the same batch for it finds the slot empty */
+void unwatchFd(int fd) {
+    for (int i = 0; i < maxWatches; ++i) if (watches[i].fd == fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+        watches[i].fd = -1;
+    }
+}
+
+void setTimer(int fd, long ms) {
+    struct itimerspec its;
+    its.it_interval.tv_sec = ms / 1000;
+    its.it_interval.tv_nsec = ms % 1000 * 1000000;
+    its.it_value = its.it_interval;
+    timerfd_settime(fd, 0, &its, NULL);
+}
+
+int watchTimer(long ms, FdHandler h, void *ctx, enum StatTimer t) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) return -1;
+    setTimer(fd, ms);
+    watchFd(fd, h, ctx, t, 0);
+    return fd;
+}
+
+void watchDeadline(long long const *due, FdHandler h, void *ctx, enum StatTimer t) {
+    deadline = due;
+    onDeadline = (Watch){-1, h, ctx, t};
+}
+
+/* in whole ms, rounded up so it never wakes before the deadline */
+static int timeoutMs() {
+    if (!deadline || !*deadline) return -1;
+    long long left = *deadline - nowNs();
+    return left > 0 ? (left + 999999) / 1000000 : 0;
+}
+
+void runReactor() {
+    struct epoll_event evs[maxWatches];
+    for (;;) {
+        int n = epoll_wait(epollFd, evs, maxWatches, timeoutMs());
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("event loop failed.");
+            exit(20);
+        }
+        statCount(statWakeups);
+        long long woke = nowNs();
+        for (int i = 0; i < n; ++i) {
+            Watch *w = evs[i].data.ptr;
+            if (w->fd < 0) continue;
+            w->handler(w->ctx, w->fd);
+            statTime(w->timer, nowNs() - woke);
+        }
+        if (deadline && *deadline && *deadline <= nowNs()) {
+            onDeadline.handler(onDeadline.ctx, -1);
+            statTime(onDeadline.timer, nowNs() - woke);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "stats.h"
+
+/* The one event loop of the daemon: every subsystem registers the fds it
+ * waits on, each with a handler, and the main thread sleeps in epoll_wait
+ * until one of them is ready. Handlers run on the main thread and must
+ * not block. The time from the wakeup to the end of a handler goes into
+ * its stat timer. An edge fd is only reported when new data arrives, for
+ * handlers that cannot drain it themselves, e.g. a connection read by a
+ * worker. */
+typedef void (*FdHandler)(void *ctx, int fd);
+
+#define maxWatches 16
+
+void initReactor();
+void watchFd(int fd, FdHandler h, void *ctx, enum StatTimer t, int edge);
+void unwatchFd(int fd);
+/* A periodic timerfd of ms with its handler, which must read it; the fd
+ * or -1. setTimer changes its period, starting from now. */
+int watchTimer(long ms, FdHandler h, void *ctx, enum StatTimer t);
+void setTimer(int fd, long ms);
+/* One deadline kept by its owner: *due, CLOCK_MONOTONIC ns or 0 for
+ * none, is the epoll_wait timeout and h is called with fd -1 once it has
+ * passed. Unlike a timerfd, that sleep honours the timer slack. */
+void watchDeadline(long long const *due, FdHandler h, void *ctx, enum StatTimer t);
+void runReactor();
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef RINGLOG_H
+#define RINGLOG_H
+
+#include <stdint.h>
+
+/* What the daemon did, as fixed size binary records in a ring file it
+ * mmaps, by default $XDG_RUNTIME_DIR/ying-bend-log: one per tick and one
+ * per action, with nothing formatted at runtime. yingLog turns it into
+ * text or CSV. Any thread may log; each record claims the next slot and
+ * its seq is set last, so a record being written, or overwritten, is
+ * seen with seq 0 or the seq of a newer one. */
+#define ringLogMagic "YBRING1"
+#define defaultLogRecords 16384
+
+enum LogType {logTick = 1, logRotate, logInput, logBind, logUevent, logBacklight,
+    logDisplay, logRediscover, logMotion, logTabletMode, nrLogTypes};
+
+/* logTick flags */
+#define logDormant 1
+#define logSettled 2
+#define logRejected 4
+
+typedef struct LogRecord {
+    uint64_t seq;           /* 1 for the first record ever written */
+    int64_t ns;             /* CLOCK_MONOTONIC */
+    uint8_t type, orient, ff, flags;
+    int32_t value;          /* backlight permille, enabled, bound, step... */
+    int64_t latencyNs;      /* tick: handling so far, action: from the sample on */
+    union {
+        struct { int32_t accel[4][3], als[2]; } raw;  /* logTick, as read */
+        char name[56];      /* the others: what was acted on */
+    } u;
+} LogRecord;
+
+typedef struct RingLogHeader {
+    char magic[8];
+    uint32_t recordSize, records;
+    uint64_t head;          /* records ever claimed */
+    char pad[40];
+} RingLogHeader;
+
+/* nonzero if the file cannot be made; without it nothing is logged */
+int openRingLog(char const *fn, long records);
+/* Copies r, with its seq and, when 0, its ns filled in, to the next slot. */
+void writeLog(LogRecord *r);
+/* An action record in one go; name may be NULL. */
+void logAction(enum LogType type, int value, long long latencyNs, char const *name);
+
+#endif
@@ -0,0 +1,64 @@
+#include <sys/prctl.h>
+#include "core.h"
+#include "sched.h"
+
+/* relative change of a vector, about 3 degrees, that counts as movement */
+#define motionRatio 0.05
+
+static void armSched(Sched *s, long ms) {
+    s->curMs = ms;
+    s->due = ms ? nowNs() + ms * 1000000LL : 0;
+    prctl(PR_SET_TIMERSLACK, ms * 1000000 / 8);
+}
+
+void initSched(Sched *s, long fastMs, long idleMs) {
+    s->fastMs = fastMs > 0 ? fastMs : defaultFastMs;
+    s->idleMs = idleMs >= s->fastMs ? idleMs : s->fastMs;
+    s->haveLast = 0;
+    armSched(s, s->fastMs);
+}
+
+/* Like a periodic timer the ticks stay on the period's grid, and the
+ * ones missed while busy or suspended are dropped. */
+int ackTick(Sched *s) {
+    long long now = nowNs();
+    if (!s->due || now < s->due) return 1;
+    if (!s->curMs) s->due = 0;
+    else while (s->due <= now) s->due += s->curMs * 1000000LL;
+    return 0;
+}
+
+/* v is the averaged screen vector followed by the keyboard one */
+int sampleMoved(Sched *s, double const v[6]) {
+    int moved = !s->haveLast;
+    for (int i = 0; i < 6 && !moved; i += 3) {
+        double d = 0.0, m = 0.0;
+        for (int j = i; j < i + 3; ++j) {
+            d += (v[j] - s->last[j]) * (v[j] - s->last[j]);
+            m += s->last[j] * s->last[j];
+        }
+        moved = d > motionRatio * motionRatio * m;
+    }
+    for (int i = 0; i < 6; ++i) s->last[i] = v[i];
+    s->haveLast = 1;
+    return moved;
+}
+
+/* Rearms the timer only when the period actually changes. */
+void adaptSched(Sched *s, int moving) {
+    long next = moving ? s->fastMs : s->curMs * 2;
+    if (next > s->idleMs) next = s->idleMs;
+    if (next != s->curMs) armSched(s, next);
+}
+
+void parkSched(Sched *s, long ms) {
+    if (ms != s->curMs) armSched(s, ms);
+}
+
+void stopSched(Sched *s) {
+    if (s->curMs) armSched(s, 0);
+}
+
+void kickSched(Sched *s) {
+    s->due = nowNs();
+}
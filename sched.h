@@ -0,0 +1,31 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+/* Sampling clock: a period of fastMs while the accelerometer vectors
+ * move that doubles on every quiet tick until it reaches idleMs. It is
+ * the reactor's deadline, so the loop sleeps in epoll_wait, whose timeout
+ * (unlike a timerfd) takes the timer slack; that grows with the period so
+ * the kernel can batch the idle wakeups with others. */
+typedef struct Sched {
+    long long due;          /* CLOCK_MONOTONIC ns of the next tick, 0 when stopped */
+    long fastMs, idleMs, curMs;
+    int haveLast;
+    double last[6];
+} Sched;
+
+#define defaultFastMs 66
+#define defaultIdleMs 4000
+
+void initSched(Sched *s, long fastMs, long idleMs);
+/* on the deadline, 0 when the period is over, nonzero for nothing to do */
+int ackTick(Sched *s);
+int sampleMoved(Sched *s, double const v[6]);
+void adaptSched(Sched *s, int moving);
+/* holds the period at ms, e.g. while the display is off */
+void parkSched(Sched *s, long ms);
+/* no more ticks until the next kick, e.g. when events say when to look */
+void stopSched(Sched *s);
+/* a tick right away, then the current period (none when stopped) */
+void kickSched(Sched *s);
+
+#endif
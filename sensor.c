@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "sensor.h"
+
+char const *sysRoot = "";
+
+/* Formats a path below sysRoot, returns non zero if it did not fit. */
+int sysPath(char *buf, int size, char const *fmt, ...) {
+    int n = snprintf(buf, size, "%s", sysRoot);
+    if (n >= size) return 1;
+    va_list ap;
+    va_start(ap, fmt);
+    int m = vsnprintf(buf + n, size - n, fmt, ap);
+    va_end(ap);
+    return m >= size - n;
+}
+
+void openSensor(Sensor *s, char const *path) {
+    s->path = path;
+    s->fd = open(path, O_RDONLY | O_CLOEXEC);
+    s->reopened = 0;
+}
+
+void closeSensor(Sensor *s) {
+    if (s->fd >= 0) close(s->fd);
+    s->fd = -1;
+}
+
+/* sysfs raw values are plain decimal integers, no need for the
+ * locale aware strtod/fscanf machinery. */
+static double parseInt(char const *buf) {
+    long rez = 0;
+    int neg = 0;
+    while (*buf == ' ' || *buf == '\t') ++buf;
+    if (*buf == '-') { neg = 1; ++buf; }
+    else if (*buf == '+') ++buf;
+    for (; *buf >= '0' && *buf <= '9'; ++buf) rez = rez * 10 + (*buf - '0');
+    return neg ? -rez : rez;
+}
+
+static int preadSensor(Sensor *s, char *buf, int size) {
+    if (s->fd < 0) return -1;
+    int r = pread(s->fd, buf, size - 1, 0);
+    if (r <= 0) return -1;
+    buf[r] = 0;
+    return r;
+}
+
+double readSensor(Sensor *s) {
+    char buf[32];
+    if (preadSensor(s, buf, sizeof(buf)) < 0) {
+        /* device went away (resume, driver rebind), try once to get it back */
+        closeSensor(s);
+        openSensor(s, s->path);
+        s->reopened = 1;
+        if (preadSensor(s, buf, sizeof(buf)) < 0) return 0.0;
+    }
+    return parseInt(buf);
+}
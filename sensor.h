@@ -0,0 +1,23 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+/* A sysfs attribute kept open for the lifetime of the daemon.
+ * Each read is a single pread at offset 0, which makes the kernel
+ * regenerate the value, so no path lookup happens on the hot path. */
+typedef struct Sensor {
+    int fd;
+    char const *path;
+    int reopened;   /* set when a read had to open the path again */
+} Sensor;
+
+/* Prefix of every /sys and /dev path, "" on the real device. */
+extern char const *sysRoot;
+int sysPath(char *buf, int size, char const *fmt, ...);
+
+void openSensor(Sensor *s, char const *path);
+double readSensor(Sensor *s);
+/* the last read failed and so did reopening the path */
+#define sensorLost(s) ((s)->fd < 0)
+void closeSensor(Sensor *s);
+
+#endif
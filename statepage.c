@@ -0,0 +1,44 @@
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "statepage.h"
+
+static StatePage *page = NULL;
+
+int openStatePage(char const *fn) {
+    int fd = open(fn, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return 1;
+    if (ftruncate(fd, sizeof(StatePage))) {
+        close(fd);
+        return 1;
+    }
+    void *p = mmap(NULL, sizeof(StatePage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return 1;
+    page = p;
+    /* a page left by an earlier run keeps its counters, so readers
+     * waiting on it see the restart as a change */
+    if (page->magic != statePageMagic || page->version != statePageVersion) {
+        memset(page, 0, sizeof(*page));
+        page->version = statePageVersion;
+        __atomic_store_n(&page->magic, statePageMagic, __ATOMIC_RELEASE);
+    } else if (page->seq & 1) __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* No syscall unless the decision changed and someone may be waiting. */
+void publishState(YingState const *s, int changed) {
+    if (!page) return;
+    uint32_t seq = page->seq;
+    __atomic_store_n(&page->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    page->state = *s;
+    __atomic_store_n(&page->seq, seq + 2, __ATOMIC_RELEASE);
+    if (!changed) return;
+    __atomic_fetch_add(&page->changes, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &page->changes, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
@@ -0,0 +1,63 @@
+#ifndef STATEPAGE_H
+#define STATEPAGE_H
+
+#include <stdint.h>
+#include <limits.h>
+
+/* The latest decision, published for other programs (on-screen keyboard,
+ * panel, scripts) in a small file they mmap, by default
+ * $XDG_RUNTIME_DIR/ying-bend-state. The daemon is the only writer; it
+ * makes seq odd while it writes and even again after, so a reader that
+ * sees the same even seq before and after its copy has a consistent one.
+ * changes counts the orientation and form factor changes and is a futex:
+ * it is woken on each of them, so readers can wait without polling.
+ * Nothing here needs the daemon's headers: the orientations are the
+ * RandR rotations, the form factors those of decide.h, by value. */
+#define statePageMagic 0x59425354
+#define statePageVersion 2
+
+enum {stateHorizontal = 0, stateRightward = 1, stateDownward = 2, stateLeftward = 4,
+    stateUpward = 8};
+enum {stateLaptop, stateTablet, stateUndefinedFF, stateBorderFF};
+
+/* where a daemon outside any session keeps its state page and log */
+#define yingRunDir "/run/ying-bend"
+
+typedef struct YingState {
+    int32_t orient;         /* stateUpward.., stateHorizontal */
+    int32_t ff;             /* stateLaptop.. */
+    double screen[3];       /* averaged screen accelerometer x, y, z */
+    double keyboard[3];     /* and the keyboard one, in the screen's axes */
+    double backlight;       /* wanted backlight 0.15..1, 0 without the ALS */
+    uint64_t sample;        /* counts the samples published */
+    int64_t nowNs;          /* CLOCK_MONOTONIC of the sample */
+} YingState;
+
+typedef struct StatePage {
+    uint32_t magic, version;
+    uint32_t seq, changes;
+    YingState state;
+} StatePage;
+
+/* Daemon side, the file is created if needed; nonzero if it cannot be. */
+int openStatePage(char const *fn);
+void publishState(YingState const *s, int changed);
+
+/* Reader side, in libyingstate.a: no syscall but for open and wait. */
+/* The default file of a reader, name being "state" or "log": that of
+ * the session daemon, $XDG_RUNTIME_DIR/ying-bend-name, when there is
+ * one, else that of the system one under yingRunDir. */
+char const *runtimePath(char fn[PATH_MAX], char const *name);
+StatePage const *mapState(char const *fn);
+/* Copies a consistent state, retrying while the daemon writes; -1 with
+ * errno EAGAIN if it never finishes (it died writing), s is then torn. */
+int readState(StatePage const *p, YingState *s);
+/* Waits while changes is still seen, at most timeoutMs (-1 forever), and
+ * returns the new count. */
+uint32_t waitState(StatePage const *p, uint32_t seen, int timeoutMs);
+/* A screen or keyboard vector as alt, lat, lon, the angles in degrees. */
+void statePolar(double const xyz[3], double polar[3]);
+char const *stateOrientName(int32_t orient);
+extern char const *const stateFormName[4];
+
+#endif
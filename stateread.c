@@ -0,0 +1,79 @@
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "statepage.h"
+
+char const *runtimePath(char fn[PATH_MAX], char const *name) {
+    char const *dir = getenv("XDG_RUNTIME_DIR");
+    if (dir && *dir) {
+        snprintf(fn, PATH_MAX, "%s/ying-bend-%s", dir, name);
+        if (!access(fn, R_OK)) return fn;
+    }
+    snprintf(fn, PATH_MAX, yingRunDir "/%s", name);
+    return fn;
+}
+
+StatePage const *mapState(char const *fn) {
+    int fd = open(fn, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    void *p = mmap(NULL, sizeof(StatePage), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    StatePage const *page = p;
+    if (__atomic_load_n(&page->magic, __ATOMIC_ACQUIRE) != statePageMagic ||
+            page->version != statePageVersion) {
+        munmap(p, sizeof(StatePage));
+        errno = EINVAL;
+        return NULL;
+    }
+    return page;
+}
+
+/* A write is a few stores, so a seq that stays odd this long is a
+ * daemon that died in the middle of one. */
+#define stateReadTries 10000
+
+int readState(StatePage const *p, YingState *s) {
+    for (int i = 0; i < stateReadTries; ++i) {
+        uint32_t seq = __atomic_load_n(&p->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) continue;
+        *s = p->state;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&p->seq, __ATOMIC_RELAXED) == seq) return 0;
+    }
+    errno = EAGAIN;
+    return -1;
+}
+
+uint32_t waitState(StatePage const *p, uint32_t seen, int timeoutMs) {
+    struct timespec ts = {timeoutMs / 1000, timeoutMs % 1000 * 1000000L};
+    uint32_t now = __atomic_load_n(&p->changes, __ATOMIC_ACQUIRE);
+    if (now == seen) syscall(SYS_futex, &p->changes, FUTEX_WAIT, seen,
+            timeoutMs < 0 ? NULL : &ts, NULL, 0);
+    return __atomic_load_n(&p->changes, __ATOMIC_ACQUIRE);
+}
+
+void statePolar(double const xyz[3], double polar[3]) {
+    polar[0] = sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1] + xyz[2] * xyz[2]);
+    polar[1] = atan2(xyz[2], sqrt(xyz[0] * xyz[0] + xyz[1] * xyz[1])) * 180.0 / M_PI;
+    polar[2] = atan2(xyz[1], xyz[0]) * 180.0 / M_PI;
+}
+
+char const *stateOrientName(int32_t orient) {
+    switch (orient) {
+    case stateUpward: return "upward";
+    case stateDownward: return "downward";
+    case stateLeftward: return "leftward";
+    case stateRightward: return "rightward";
+    default: return "horiz";
+    }
+}
+
+char const *const stateFormName[4] = {"lap", "tab", "undef", "bor"};
@@ -0,0 +1,151 @@
+#define _GNU_SOURCE
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "core.h"
+#include "stats.h"
+#include "reactor.h"
+
+long statCounters[nrStatCounters];
+Histogram statTimers[nrStatTimers];
+
+static char const *counterNames[nrStatCounters] = {"wakeups", "samples",
+    "accel_rejects", "als_rejects", "x_transitions", "x_round_trips",
+    "actuator_coalesced", "actuator_queue_full", "driver_uevents", "iio_rediscoveries",
+    "dormant_ticks", "display_wakes", "motion_events"};
+static char const *timerNames[nrStatTimers] = {"accel0_read", "accel1_read",
+    "accel2_read", "accel3_read", "als_read", "rotate_screen",
+    "modify_property", "driver_bind", "rotate_done", "input_done", "driver_done",
+    "tick_handled", "x_events_handled", "uevents_handled", "control_handled",
+    "motion_handled", "ramp_handled"};
+
+static long long statStart;
+
+void statTime(enum StatTimer t, long long ns) {
+    Histogram *h = &statTimers[t];
+    int b = ns > 0 ? 64 - __builtin_clzll(ns) : 0;
+    if (b >= statBuckets) b = statBuckets - 1;
+    __atomic_fetch_add(&h->buckets[b], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sumNs, ns, __ATOMIC_RELAXED);
+    long long max = __atomic_load_n(&h->maxNs, __ATOMIC_RELAXED);
+    while (ns > max && !__atomic_compare_exchange_n(&h->maxNs, &max, ns, 1,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void onUsr1(void *ctx, int fd) {
+    struct signalfd_siginfo si;
+    while (read(fd, &si, sizeof(si)) == sizeof(si)) dumpStats(2);
+}
+
+/* A control client sends one command per line and gets the answer back;
+ * one that hangs up without any gets the counters, like a bare connect. */
+#define maxClients 4
+
+typedef struct Client {
+    int fd, commands, len;
+    char line[128];
+} Client;
+
+static Client clients[maxClients];
+
+static void command(Client *c, char *cmd) {
+    ++c->commands;
+    if (!*cmd || !strcmp(cmd, "stats")) dumpStats(c->fd);
+    else if (!strcmp(cmd, "sample")) {
+        sampleNow();
+        dprintf(c->fd, "ok\n");
+    } else if (!strcmp(cmd, "display off") || !strcmp(cmd, "display on")) {
+        setDisplayOff(!strcmp(cmd, "display off"));
+        dprintf(c->fd, "ok\n");
+    } else dprintf(c->fd, "unknown command, have: stats, sample, display on|off\n");
+}
+
+static void onClient(void *ctx, int fd) {
+    Client *c = ctx;
+    int r = read(fd, c->line + c->len, sizeof(c->line) - 1 - c->len);
+    if (r > 0) {
+        c->len += r;
+        c->line[c->len] = 0;
+        char *nl;
+        while ((nl = strchr(c->line, '\n'))) {
+            *nl = 0;
+            if (nl > c->line && nl[-1] == '\r') nl[-1] = 0;
+            command(c, c->line);
+            c->len -= nl + 1 - c->line;
+            memmove(c->line, nl + 1, c->len + 1);
+        }
+        if (c->len < (int)sizeof(c->line) - 1) return;
+    } else if (!c->commands) dumpStats(fd);
+    unwatchFd(fd);
+    close(fd);
+    c->fd = -1;
+}
+
+static void onControl(void *ctx, int fd) {
+    int s;
+    while ((s = accept4(fd, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+        Client *c = NULL;
+        for (int i = 0; i < maxClients && !c; ++i) if (clients[i].fd < 0) c = &clients[i];
+        if (!c) {
+            dumpStats(s);
+            close(s);
+            continue;
+        }
+        c->fd = s;
+        c->commands = c->len = 0;
+        watchFd(s, onClient, c, timeControlHandled, 0);
+    }
+}
+
+/* SIGUSR1 comes through a signalfd, so it is blocked here, before any
+ * thread is started, and the dump happens on the loop. */
+void initStats(char const *sockPath) {
+    sigset_t usr1;
+    sigemptyset(&usr1);
+    sigaddset(&usr1, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &usr1, NULL);
+    int sfd = signalfd(-1, &usr1, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (sfd >= 0) watchFd(sfd, onUsr1, NULL, timeControlHandled, 0);
+    statStart = nowNs();
+    for (int i = 0; i < maxClients; ++i) clients[i].fd = -1;
+    if (!sockPath) return;
+    struct sockaddr_un addr = {AF_UNIX};
+    if (strlen(sockPath) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "stats socket path too long.\n");
+        return;
+    }
+    strcpy(addr.sun_path, sockPath);
+    int statSock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(sockPath);
+    if (statSock < 0 || bind(statSock, (struct sockaddr *)&addr, sizeof(addr))
+            || listen(statSock, 4)) {
+        perror("cannot open stats socket");
+        if (statSock >= 0) close(statSock);
+        return;
+    }
+    watchFd(statSock, onControl, NULL, timeControlHandled, 0);
+}
+
+void dumpStats(int fd) {
+    double hours = (nowNs() - statStart) / 3600e9;
+    for (int i = 0; i < nrStatCounters; ++i)
+        dprintf(fd, "%s %ld\n", counterNames[i], statCounters[i]);
+    dprintf(fd, "wakeups_per_hour %.0f\n", hours > 0 ? statCounters[statWakeups] / hours : 0.0);
+    dprintf(fd, "x_round_trips_per_transition %.2f\n", statCounters[statXTransitions] ?
+            (double)statCounters[statXRoundTrips] / statCounters[statXTransitions] : 0.0);
+    for (int i = 0; i < nrStatTimers; ++i) {
+        Histogram const *h = &statTimers[i];
+        if (!h->count) continue;
+        dprintf(fd, "%s count %ld mean_ns %lld max_ns %lld log2_ns", timerNames[i],
+                h->count, h->sumNs / h->count, h->maxNs);
+        for (int b = 0; b < statBuckets; ++b)
+            if (h->buckets[b]) dprintf(fd, " %d:%ld", b, h->buckets[b]);
+        dprintf(fd, "\n");
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef STATS_H
+#define STATS_H
+
+/* Always-on counters and log2 latency histograms, cheap enough for every
+ * tick and safe to update from the actuator workers. They are dumped on
+ * SIGUSR1 (to stderr) and to the clients of the control socket. The *Done
+ * timers are from the sample to the action done, the *Handled ones from
+ * the loop waking up to the handler done. */
+enum StatCounter {statWakeups, statSamples, statAccelRejects, statAlsRejects,
+    statXTransitions, statXRoundTrips, statCoalesced, statQueueFull, statDriverUevents, statRediscoveries,
+    statDormantTicks, statDisplayWakes, statMotionEvents, nrStatCounters};
+enum StatTimer {timeAccel0, timeAccel1, timeAccel2, timeAccel3, timeAls,
+    timeRotate, timeModifyProperty, timeDriverBind,
+    timeRotateDone, timeInputDone, timeDriverDone,
+    timeTickHandled, timeXHandled, timeUeventHandled, timeControlHandled,
+    timeMotionHandled, timeRampHandled, nrStatTimers};
+
+#define statBuckets 40
+
+typedef struct Histogram {
+    long count;
+    long long sumNs, maxNs;
+    long buckets[statBuckets];  /* bucket i: 2^(i-1) <= ns < 2^i */
+} Histogram;
+
+extern long statCounters[nrStatCounters];
+extern Histogram statTimers[nrStatTimers];
+
+#define statCountN(c, n) __atomic_fetch_add(&statCounters[c], (n), __ATOMIC_RELAXED)
+#define statCount(c) statCountN(c, 1)
+
+void statTime(enum StatTimer t, long long ns);
+/* times the statement s into timer t */
+#define statTimed(t, s) do { long long t0_ = nowNs(); s; statTime(t, nowNs() - t0_); } while (0)
+
+/* Serves the control socket at sockPath, which may be NULL for none,
+ * on the event loop; see command() for what it answers to. */
+void initStats(char const *sockPath);
+void dumpStats(int fd);
+
+#endif
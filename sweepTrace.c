@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include "trace.h"
+
+/* Writes the trace `make check` replays with --compare: random screen
+ * and keyboard vectors, then slow sweeps through every latitude,
+ * longitude and screen/keyboard tilt threshold, both ways so the
+ * hysteresis is crossed from each side. The samples are 10 s apart, past
+ * the low pass and the dwell, so each one is decided on its own.
+ *     sweepTrace file */
+static unsigned ms = 0;
+static int fd;
+
+static void sample(double const screen[3], double const keyboard[3]) {
+    double accel[traceAccels][3], als[traceAls] = {100, 100};
+    for (int i = 0; i < traceAccels; ++i) for (int j = 0; j < 3; ++j)
+        accel[i][j] = (int)(i % 2 ? keyboard : screen)[j];
+    writeTraceAt(fd, ms += 10000, accel, als);
+}
+
+static void unit(double lat, double lon, double r, double v[3]) {
+    lat *= M_PI / 180.0;
+    lon *= M_PI / 180.0;
+    v[0] = r * cos(lat) * cos(lon);
+    v[1] = r * cos(lat) * sin(lon);
+    v[2] = r * sin(lat);
+}
+
+/* xorshift, so the trace is the same everywhere */
+static uint64_t seed = 88172645463325252ULL;
+
+static double uniform(double lo, double hi) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return lo + (hi - lo) * (seed >> 11) * (1.0 / 9007199254740992.0);
+}
+
+int main(int argc, char *argv[]) {
+    double s[3], k[3], up[3] = {0, 1e6, 0};
+    if (argc != 2 || (fd = openTraceOut(argv[1])) < 0) {
+        perror("sweepTrace file");
+        return 1;
+    }
+    for (int i = 0; i < 200000; ++i) {
+        unit(asin(uniform(-1, 1)) * 180.0 / M_PI, uniform(-180, 180), uniform(2e5, 2e6), s);
+        for (int j = 0; j < 3; ++j) k[j] = uniform(-2e6, 2e6);
+        sample(s, k);
+    }
+    for (int dir = 1; dir >= -1; dir -= 2) for (int i = -9000; i <= 9000; i += 7) {
+        unit(dir * i * 0.01, 30, 1e6, s);
+        sample(s, up);
+    }
+    for (int dir = 1; dir >= -1; dir -= 2) for (int i = -18000; i <= 18000; i += 3) {
+        unit(10, dir * i * 0.01, 1e6, s);
+        sample(s, up);
+    }
+    /* the keyboard after its 90 degree turn is (y, -x, z), the screen
+     * goes round it in the x-z plane */
+    double down[3] = {0, -1e6, 0};
+    for (int dir = 1; dir >= -1; dir -= 2) for (int i = -18000; i <= 18000; i += 3) {
+        double a = dir * i * 0.01 * M_PI / 180.0;
+        double t[3] = {1e6 * cos(a), 0, 1e6 * sin(a)};
+        sample(t, down);
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/uinput.h>
+#include "sensor.h"
+#include "core.h"
+#include "actuators.h"
+#include "ringlog.h"
+
+/* A uinput device with one switch, SW_TABLET_MODE, that follows the
+ * laptop/tablet decision, so the compositor, the on-screen keyboard and
+ * the input daemons get it as one kernel event instead of polling. Under
+ * a --root tree dev/uinput may be a plain file: the device cannot be
+ * created there, and the events are just appended to it. */
+static int uinputFd = -1;
+
+static int createDevice(int fd) {
+    struct uinput_setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.id.bustype = BUS_VIRTUAL;
+    strcpy(setup.name, "ying-bend tablet mode");
+    if (ioctl(fd, UI_SET_EVBIT, EV_SW) || ioctl(fd, UI_SET_SWBIT, SW_TABLET_MODE)) return -1;
+    if (ioctl(fd, UI_DEV_SETUP, &setup) || ioctl(fd, UI_DEV_CREATE)) return -1;
+    return 0;
+}
+
+static void initTabletMode() {
+    char path[PATH_MAX];
+    if (sysPath(path, PATH_MAX, "/dev/uinput")) return;
+    uinputFd = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (uinputFd >= 0 && (!createDevice(uinputFd) || *sysRoot)) return;
+    perror("cannot create the tablet mode switch");
+    if (uinputFd >= 0) close(uinputFd);
+    uinputFd = -1;
+}
+
+static void emit(int type, int code, int value) {
+    struct input_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = type;
+    ev.code = code;
+    ev.value = value;
+    if (write(uinputFd, &ev, sizeof(ev)) != sizeof(ev)) perror("cannot send the tablet mode");
+}
+
+static Formfactor lastFF = undefinedFF;
+
+static void applyTabletMode(Decision const *d) {
+    if (uinputFd < 0 || d->ff == undefinedFF || d->ff == borderFF || d->ff == lastFF) return;
+    lastFF = d->ff;
+    emit(EV_SW, SW_TABLET_MODE, tablet == lastFF);
+    emit(EV_SYN, SYN_REPORT, 0);
+    logAction(logTabletMode, tablet == lastFF, nowNs() - d->now, "SW_TABLET_MODE");
+}
+
+Actuator const tabletModeActuator = {"tabletmode", 0, initTabletMode, applyTabletMode, NULL, inlineLane};
@@ -0,0 +1,66 @@
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "trace.h"
+
+static char const traceMagic[8] = "YBTRACE1";
+
+typedef struct TraceRecord {
+    uint32_t ms;
+    int32_t accel[traceAccels][3];
+    int32_t als[traceAls];
+} TraceRecord;
+
+static struct timespec traceStart;
+
+int openTraceOut(char const *fn) {
+    int fd = open(fn, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+    if (write(fd, traceMagic, sizeof(traceMagic)) != sizeof(traceMagic)) {
+        close(fd);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &traceStart);
+    return fd;
+}
+
+void writeTrace(int fd, double const accel[traceAccels][3], double const als[traceAls]) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    writeTraceAt(fd, (now.tv_sec - traceStart.tv_sec) * 1000 +
+            (now.tv_nsec - traceStart.tv_nsec) / 1000000, accel, als);
+}
+
+/* One write() per sample, so a killed daemon leaves a usable trace. */
+void writeTraceAt(int fd, unsigned ms, double const accel[traceAccels][3], double const als[traceAls]) {
+    TraceRecord r;
+    r.ms = ms;
+    for (int i = 0; i < traceAccels; ++i) for (int j = 0; j < 3; ++j)
+        r.accel[i][j] = accel[i][j];
+    for (int i = 0; i < traceAls; ++i) r.als[i] = als ? als[i] : 0;
+    if (write(fd, &r, sizeof(r)) != sizeof(r)) perror("cannot write trace");
+}
+
+FILE *openTraceIn(char const *fn) {
+    char magic[sizeof(traceMagic)];
+    FILE *f = fopen(fn, "rb");
+    if (!f) return NULL;
+    if (fread(magic, sizeof(magic), 1, f) != 1 || memcmp(magic, traceMagic, sizeof(magic))) {
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+/* Returns 1 while there are records, 0 at the end of the trace. */
+int readTrace(FILE *f, unsigned *ms, double accel[traceAccels][3], double als[traceAls]) {
+    TraceRecord r;
+    if (fread(&r, sizeof(r), 1, f) != 1) return 0;
+    *ms = r.ms;
+    for (int i = 0; i < traceAccels; ++i) for (int j = 0; j < 3; ++j)
+        accel[i][j] = r.accel[i][j];
+    if (als) for (int i = 0; i < traceAls; ++i) als[i] = r.als[i];
+    return 1;
+}
@@ -0,0 +1,20 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+/* Sensor trace: a header followed by fixed size native endian records
+ * of the raw accelerometer and ALS values, stamped with the milliseconds
+ * elapsed since recording started. */
+
+#define traceAccels 4
+#define traceAls 2
+
+int openTraceOut(char const *fn);
+void writeTrace(int fd, double const accel[traceAccels][3], double const als[traceAls]);
+/* the same with the stamp given, for made up traces */
+void writeTraceAt(int fd, unsigned ms, double const accel[traceAccels][3], double const als[traceAls]);
+FILE *openTraceIn(char const *fn);
+int readTrace(FILE *f, unsigned *ms, double accel[traceAccels][3], double als[traceAls]);
+
+#endif
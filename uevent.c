@@ -0,0 +1,59 @@
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/netlink.h>
+#include "sensor.h"
+#include "uevent.h"
+
+int openUevents() {
+    if (*sysRoot) {
+        struct sockaddr_un addr = {AF_UNIX};
+        if (sysPath(addr.sun_path, sizeof(addr.sun_path), "/uevent")) return -1;
+        int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        unlink(addr.sun_path);
+        if (fd >= 0 && bind(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    struct sockaddr_nl addr = {AF_NETLINK};
+    addr.nl_groups = 1;     /* the kernel's, not udev's */
+    int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd >= 0 && bind(fd, (struct sockaddr *)&addr, sizeof(addr))) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int readUevent(int fd, char buf[ueventBufSize], Uevent *ev) {
+    struct sockaddr_nl from;
+    socklen_t fromLen = sizeof(from);
+    memset(&from, 0, sizeof(from));
+    int n = recvfrom(fd, buf, ueventBufSize - 1, 0, (struct sockaddr *)&from, &fromLen);
+    if (n < 0) return -1;
+    /* only the kernel may speak on the netlink group */
+    if (from.nl_family == AF_NETLINK && from.nl_pid) return 0;
+    buf[n] = 0;
+    char *at = strchr(buf, '@');
+    if (!at) return 0;
+    memset(ev, 0, sizeof(*ev));
+    for (char *p = buf + strlen(buf) + 1; p < buf + n; p += strlen(p) + 1) {
+        if (!strncmp(p, "ACTION=", 7)) ev->action = p + 7;
+        else if (!strncmp(p, "DEVPATH=", 8)) ev->devpath = p + 8;
+        else if (!strncmp(p, "SUBSYSTEM=", 10)) ev->subsystem = p + 10;
+        else if (!strncmp(p, "DRIVER=", 7)) ev->driver = p + 7;
+    }
+    /* the header is action@devpath, enough when the pairs are missing */
+    *at = 0;
+    if (!ev->action) ev->action = buf;
+    if (!ev->devpath) ev->devpath = at + 1;
+    return 1;
+}
+
+char const *ueventDevice(Uevent const *ev) {
+    char const *slash = strrchr(ev->devpath, '/');
+    return slash ? slash + 1 : ev->devpath;
+}
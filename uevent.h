@@ -0,0 +1,24 @@
+#ifndef UEVENT_H
+#define UEVENT_H
+
+/* Kernel uevents from the NETLINK_KOBJECT_UEVENT socket. Under a --root
+ * tree they come from a datagram socket <root>/uevent instead, where
+ * anything can inject them in the kernel format, e.g.
+ *   printf 'bind@/devices/x/i2c-WCOM0019:00\0ACTION=bind\0' |
+ *       socat -u - UNIX-SENDTO:root/uevent */
+typedef struct Uevent {
+    char const *action, *devpath, *subsystem, *driver;
+} Uevent;
+
+#define ueventBufSize 8192
+
+int openUevents();
+/* The socket does not block: reads the next message, 1 when it is a
+ * uevent, 0 for anything else and -1 on error or when there is none
+ * (EAGAIN); ENOBUFS means some were lost. The fields point
+ * into buf. */
+int readUevent(int fd, char buf[ueventBufSize], Uevent *ev);
+/* the last component of the devpath */
+char const *ueventDevice(Uevent const *ev);
+
+#endif
@@ -0,0 +1,65 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "stats.h"
+#include "worker.h"
+
+static void *workerLoop(void *arg) {
+    Worker *w = arg;
+    unsigned char job[workerJobMax];
+    for (;;) {
+        while (sem_wait(&w->wake));
+        unsigned t = atomic_load_explicit(&w->tail, memory_order_relaxed);
+        unsigned h = atomic_load_explicit(&w->head, memory_order_acquire);
+        if (h == t) continue;
+        /* the producer never writes below head, so the newest slot is
+         * stable until tail moves past it */
+        memcpy(job, w->slots[(h - 1) % workerSlots], w->jobSize);
+        atomic_store_explicit(&w->running, 1, memory_order_relaxed);
+        atomic_store_explicit(&w->tail, h, memory_order_release);
+        statCountN(statCoalesced, h - t - 1);
+        w->run(w->ctx, job);
+        atomic_store_explicit(&w->running, 0, memory_order_release);
+    }
+    return NULL;
+}
+
+void startWorker(Worker *w, void (*run)(void *ctx, void const *job), void *ctx, int jobSize) {
+    w->run = run;
+    w->ctx = ctx;
+    w->jobSize = jobSize;
+    w->pendingValid = 0;
+    atomic_init(&w->head, 0);
+    atomic_init(&w->tail, 0);
+    atomic_init(&w->running, 0);
+    if (jobSize > workerJobMax || sem_init(&w->wake, 0, 0) ||
+            pthread_create(&w->thread, NULL, workerLoop, w)) {
+        perror("cannot start actuator worker.");
+        exit(19);
+    }
+}
+
+void postJob(Worker *w, void const *job) {
+    unsigned h = atomic_load_explicit(&w->head, memory_order_relaxed);
+    if (h - atomic_load_explicit(&w->tail, memory_order_acquire) >= workerSlots) {
+        statCount(statQueueFull);
+        memcpy(w->pending, job, w->jobSize);
+        w->pendingValid = 1;
+        return;
+    }
+    memcpy(w->slots[h % workerSlots], job, w->jobSize);
+    atomic_store_explicit(&w->head, h + 1, memory_order_release);
+    w->pendingValid = 0;
+    sem_post(&w->wake);
+}
+
+void retryJob(Worker *w) {
+    if (w->pendingValid) postJob(w, w->pending);
+}
+
+int workerIdle(Worker *w) {
+    /* tail first: once it covers head, running was already raised */
+    unsigned t = atomic_load_explicit(&w->tail, memory_order_acquire);
+    return t == atomic_load_explicit(&w->head, memory_order_acquire) &&
+        !atomic_load_explicit(&w->running, memory_order_acquire);
+}
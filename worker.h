@@ -0,0 +1,34 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+
+/* A thread fed through a lock-free single producer, single consumer ring.
+ * The jobs describe a wanted state, so when the thread wakes up it runs
+ * only the newest one queued and the older ones are superseded. */
+#define workerSlots 16
+#define workerJobMax 32
+
+typedef struct Worker {
+    void (*run)(void *ctx, void const *job);
+    void *ctx;
+    int jobSize;
+    unsigned char slots[workerSlots][workerJobMax];
+    atomic_uint head, tail;
+    atomic_int running;
+    sem_t wake;
+    pthread_t thread;
+    int pendingValid;                   /* producer side: a job the full ring refused */
+    unsigned char pending[workerJobMax];
+} Worker;
+
+void startWorker(Worker *w, void (*run)(void *ctx, void const *job), void *ctx, int jobSize);
+/* never blocks; a job that does not fit is kept and retried by retryJob */
+void postJob(Worker *w, void const *job);
+void retryJob(Worker *w);
+/* nothing queued and nothing running */
+int workerIdle(Worker *w);
+
+#endif
@@ -0,0 +1,529 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <X11/extensions/Xrandr.h>
+#include <X11/extensions/XInput2.h>
+#include <X11/extensions/scrnsaver.h>
+#include <X11/extensions/dpms.h>
+#include <X11/extensions/dpmsproto.h>
+#include <X11/extensions/Xge.h>
+#include <X11/Xlib-xcb.h>
+#include <X11/Xlibint.h>
+#include <xcb/randr.h>
+#include <xcb/xinput.h>
+#include <X11/Xatom.h>
+#include "core.h"
+#include "actuators.h"
+#include "xact.h"
+#include "stats.h"
+#include "reactor.h"
+#include "ringlog.h"
+
+int needSwapDims(int curR, int targR) {
+    if (curR == RR_Rotate_90 || curR == RR_Rotate_270) {
+        if (targR == RR_Rotate_0 || targR == RR_Rotate_180) return 1;
+    } else {
+        if (targR == RR_Rotate_90 || targR == RR_Rotate_270) return 1;
+    }
+    return 0;
+}
+
+/* The input devices we touch, matched by name prefix. Their ids and the
+ * property atoms are resolved once and kept until XI_HierarchyChanged. */
+char const *xiTargetNames[nrXiTargets] = {"HDP0001:00 2ABB:8102", "Wacom HID 169 Pen ",
+    "virtual-keyboard", "virtual-touchpad"};
+#define maxXiIds 8
+struct {
+    int valid;
+    int ids[nrXiTargets][maxXiIds];
+    int count[nrXiTargets];
+} xiCache;
+char *xiAtomNames[nrXiAtoms] = {"Coordinate Transformation Matrix", "Device Enabled", "FLOAT"};
+Atom xiAtoms[nrXiAtoms];
+int xiOpcode = -1;
+
+void loadXiCache(Display *disp) {
+    int devCount = 0;
+    memset(&xiCache, 0, sizeof(xiCache));
+    XIDeviceInfo *devs = XIQueryDevice(disp, XIAllDevices, &devCount);
+    statCount(statXRoundTrips);
+    if (!devs) return;
+    for (int i = 0; i < devCount; ++i) for (int j = 0; j < nrXiTargets; ++j)
+        if (!strncmp(xiTargetNames[j], devs[i].name, strlen(xiTargetNames[j]))
+                && xiCache.count[j] < maxXiIds)
+            xiCache.ids[j][xiCache.count[j]++] = devs[i].deviceid;
+    XIFreeDeviceInfo(devs);
+    xiCache.valid = 1;
+}
+
+static int loadCachesXcb(Display *disp, int wantRR, int wantXi);
+
+/* Only queues the change; the caller flushes once per transition. A device
+ * lacking the property answers with BadMatch, which ignoreXError swallows. */
+void modifyProperty(Display *disp, enum XiTarget target, Atom property,
+        Atom type, int format, void *content, int count) {
+    long long t0 = nowNs();
+    if (!xiCache.valid) {
+        if (useXcb) loadCachesXcb(disp, 0, 1);
+        else loadXiCache(disp);
+    }
+    for (int i = 0; i < xiCache.count[target]; ++i)
+        XIChangeProperty(disp, xiCache.ids[target][i], property,
+                type, format, PropModeReplace, content, count);
+    statTime(timeModifyProperty, nowNs() - t0);
+}
+
+void setMatrix(Display *disp, enum XiTarget target, float const *matrix) {
+    modifyProperty(disp, target, xiAtoms[matrixAtom], xiAtoms[floatAtom], 32, (void *)matrix, 9);
+}
+
+int ignoreXError(Display *disp, XErrorEvent *err) {
+    if (DEBUG) fprintf(stderr, "X error %d on request %d.%d\n",
+            err->error_code, err->request_code, err->minor_code);
+    return 0;
+}
+
+float const upMatrix[9] = {0, 1, 0, -1, 0, 1, 0, 0, 1};
+float const downMatrix[9] = {0, -1, 1, 1, 0, 0, 0, 0, 1};
+float const leftMatrix[9] = {-1, 0, 1, 0, -1, 1, 0, 0, 1};
+float const rightMatrix[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+
+char const *rrOutputName = "DSI-1";
+
+/* The output to turn among those connected with a CRTC: the one named
+ * rrOutputName, or without a name the primary one, else the first. Call
+ * with each in turn; *crtc is then set, and nonzero returned once it is
+ * the one for sure. */
+static int pickOutput(char const *name, int len, RROutput o, RROutput primary, RRCrtc c, RRCrtc *crtc) {
+    if (rrOutputName ? (int)strlen(rrOutputName) == len && !memcmp(name, rrOutputName, len) :
+            o == primary) {
+        *crtc = c;
+        return 1;
+    }
+    if (!rrOutputName && !*crtc) *crtc = c;
+    return 0;
+}
+
+/* What rotateScreen() needs to know about the output. It is filled from
+ * GetScreenResourcesCurrent (no output re-probing) and kept until the
+ * server tells us, through a RandR notify event, that something changed. */
+#define maxCrtcOutputs 4
+struct {
+    int valid;
+    Time configTimestamp, timestamp;
+    RRCrtc crtc;
+    int x, y;
+    unsigned width, height;
+    RRMode mode;
+    Rotation rotation;
+    RROutput outputs[maxCrtcOutputs];
+    int noutput;
+} rrCache;
+int rrEventBase = -1;
+
+void invalidateRRCache() {
+    rrCache.valid = 0;
+}
+
+/* Xlib: one round trip for the resources, one per output until it is
+ * found and one for its CRTC, and one for the primary without a name. */
+int loadRRCache(Display *disp) {
+    invalidateRRCache();
+    XRRScreenResources *screen = XRRGetScreenResourcesCurrent(disp, DefaultRootWindow(disp));
+    statCount(statXRoundTrips);
+    if (!screen) return 0;
+    if (DEBUG) fprintf(stderr, "iscres=%d\n", screen->noutput);
+    RROutput primary = None;
+    if (!rrOutputName) {
+        primary = XRRGetOutputPrimary(disp, DefaultRootWindow(disp));
+        statCount(statXRoundTrips);
+    }
+    RRCrtc crtc = None;
+    for (int iscres = 0, found = 0; iscres < screen->noutput && !found; ++iscres) {
+        XRROutputInfo *info = XRRGetOutputInfo(disp, screen, screen->outputs[iscres]);
+        statCount(statXRoundTrips);
+        if (!info) continue;
+        if (DEBUG) fprintf(stderr, "on=%s, crtc=%lu\n", info->name, info->crtc);
+        if (info->connection == RR_Connected && info->crtc)
+            found = pickOutput(info->name, info->nameLen, screen->outputs[iscres], primary,
+                    info->crtc, &crtc);
+        XRRFreeOutputInfo(info);
+    }
+    XRRCrtcInfo *crtc_info = NULL;
+    if (crtc) {
+        rrCache.crtc = crtc;
+        crtc_info = XRRGetCrtcInfo(disp, screen, crtc);
+        statCount(statXRoundTrips);
+    }
+    if (crtc_info) {
+        rrCache.configTimestamp = screen->configTimestamp;
+        rrCache.timestamp = crtc_info->timestamp;
+        rrCache.x = crtc_info->x;
+        rrCache.y = crtc_info->y;
+        rrCache.width = crtc_info->width;
+        rrCache.height = crtc_info->height;
+        rrCache.mode = crtc_info->mode;
+        rrCache.rotation = crtc_info->rotation;
+        rrCache.noutput = crtc_info->noutput < maxCrtcOutputs ? crtc_info->noutput : maxCrtcOutputs;
+        for (int i = 0; i < rrCache.noutput; ++i) rrCache.outputs[i] = crtc_info->outputs[i];
+        rrCache.valid = 1;
+        XRRFreeCrtcInfo(crtc_info);
+    }
+    XRRFreeScreenResources(screen);
+    if (DEBUG && rrCache.valid) fprintf(stderr, "==> %dx%d+%dx%d,m=%lu \n",
+            rrCache.x, rrCache.y, rrCache.width, rrCache.height, rrCache.mode);
+    return rrCache.valid;
+}
+
+/* XCB: the same queries as cookies. The resources go out together with
+ * the input device query when that cache is stale too, then every output
+ * and every CRTC is asked for at once and the replies are collected after,
+ * so a cold cache costs two round trips whatever the number of outputs. */
+#define maxRRObjects 16
+
+static void fillXiCacheXcb(xcb_input_xi_query_device_reply_t *devs) {
+    memset(&xiCache, 0, sizeof(xiCache));
+    for (xcb_input_xi_device_info_iterator_t it = xcb_input_xi_query_device_infos_iterator(devs);
+            it.rem; xcb_input_xi_device_info_next(&it)) {
+        char const *name = xcb_input_xi_device_info_name(it.data);
+        int len = xcb_input_xi_device_info_name_length(it.data);
+        for (int j = 0; j < nrXiTargets; ++j) {
+            int n = strlen(xiTargetNames[j]);
+            if (len >= n && !strncmp(xiTargetNames[j], name, n) && xiCache.count[j] < maxXiIds)
+                xiCache.ids[j][xiCache.count[j]++] = it.data->deviceid;
+        }
+    }
+    xiCache.valid = 1;
+}
+
+static int loadCachesXcb(Display *disp, int wantRR, int wantXi) {
+    xcb_connection_t *c = XGetXCBConnection(disp);
+    xcb_randr_get_screen_resources_current_cookie_t resCookie;
+    xcb_input_xi_query_device_cookie_t xiCookie;
+    if (wantRR) {
+        invalidateRRCache();
+        resCookie = xcb_randr_get_screen_resources_current(c, DefaultRootWindow(disp));
+    }
+    if (wantXi) xiCookie = xcb_input_xi_query_device(c, XCB_INPUT_DEVICE_ALL);
+    statCount(statXRoundTrips);
+    if (wantXi) {
+        xcb_input_xi_query_device_reply_t *devs = xcb_input_xi_query_device_reply(c, xiCookie, NULL);
+        if (devs) fillXiCacheXcb(devs);
+        free(devs);
+    }
+    if (!wantRR) return xiCache.valid;
+    xcb_randr_get_screen_resources_current_reply_t *res =
+        xcb_randr_get_screen_resources_current_reply(c, resCookie, NULL);
+    if (!res) return 0;
+    xcb_randr_output_t *outputs = xcb_randr_get_screen_resources_current_outputs(res);
+    xcb_randr_crtc_t *crtcs = xcb_randr_get_screen_resources_current_crtcs(res);
+    int noutput = xcb_randr_get_screen_resources_current_outputs_length(res);
+    int ncrtc = xcb_randr_get_screen_resources_current_crtcs_length(res);
+    if (noutput > maxRRObjects) noutput = maxRRObjects;
+    if (ncrtc > maxRRObjects) ncrtc = maxRRObjects;
+    xcb_randr_get_output_info_cookie_t outCookies[maxRRObjects];
+    xcb_randr_get_crtc_info_cookie_t crtcCookies[maxRRObjects];
+    xcb_randr_get_output_primary_cookie_t primaryCookie;
+    if (!rrOutputName) primaryCookie = xcb_randr_get_output_primary(c, DefaultRootWindow(disp));
+    for (int i = 0; i < noutput; ++i)
+        outCookies[i] = xcb_randr_get_output_info(c, outputs[i], res->config_timestamp);
+    for (int i = 0; i < ncrtc; ++i)
+        crtcCookies[i] = xcb_randr_get_crtc_info(c, crtcs[i], res->config_timestamp);
+    statCount(statXRoundTrips);
+    RROutput primary = None;
+    if (!rrOutputName) {
+        xcb_randr_get_output_primary_reply_t *p = xcb_randr_get_output_primary_reply(c, primaryCookie, NULL);
+        if (p) primary = p->output;
+        free(p);
+    }
+    RRCrtc crtc = None;
+    for (int i = 0, found = 0; i < noutput; ++i) {
+        xcb_randr_get_output_info_reply_t *info = xcb_randr_get_output_info_reply(c, outCookies[i], NULL);
+        if (!info) continue;
+        if (!found && info->connection == XCB_RANDR_CONNECTION_CONNECTED && info->crtc)
+            found = pickOutput((char const *)xcb_randr_get_output_info_name(info),
+                    xcb_randr_get_output_info_name_length(info), outputs[i], primary, info->crtc, &crtc);
+        free(info);
+    }
+    for (int i = 0; i < ncrtc; ++i) {
+        xcb_randr_get_crtc_info_reply_t *info = xcb_randr_get_crtc_info_reply(c, crtcCookies[i], NULL);
+        if (!info) continue;
+        if (crtcs[i] == crtc && crtc != None) {
+            rrCache.configTimestamp = res->config_timestamp;
+            rrCache.timestamp = info->timestamp;
+            rrCache.crtc = crtc;
+            rrCache.x = info->x;
+            rrCache.y = info->y;
+            rrCache.width = info->width;
+            rrCache.height = info->height;
+            rrCache.mode = info->mode;
+            rrCache.rotation = info->rotation;
+            xcb_randr_output_t *o = xcb_randr_get_crtc_info_outputs(info);
+            rrCache.noutput = xcb_randr_get_crtc_info_outputs_length(info);
+            if (rrCache.noutput > maxCrtcOutputs) rrCache.noutput = maxCrtcOutputs;
+            for (int j = 0; j < rrCache.noutput; ++j) rrCache.outputs[j] = o[j];
+            rrCache.valid = 1;
+        }
+        free(info);
+    }
+    free(res);
+    return rrCache.valid;
+}
+
+Display *openDisplay() {
+    Display *disp = XOpenDisplay(NULL);
+    if (!disp) return NULL;
+    int rrErrorBase;
+    if (XRRQueryExtension(disp, &rrEventBase, &rrErrorBase))
+        XRRSelectInput(disp, DefaultRootWindow(disp), RRScreenChangeNotifyMask |
+                RRCrtcChangeNotifyMask | RROutputChangeNotifyMask);
+    int xiEvent, xiError;
+    if (XQueryExtension(disp, "XInputExtension", &xiOpcode, &xiEvent, &xiError)) {
+        unsigned char mask[XIMaskLen(XI_LASTEVENT)] = {0};
+        XIEventMask evmask = {XIAllDevices, sizeof(mask), mask};
+        XISetMask(mask, XI_HierarchyChanged);
+        XISelectEvents(disp, DefaultRootWindow(disp), &evmask, 1);
+    }
+    XInternAtoms(disp, xiAtomNames, nrXiAtoms, False, xiAtoms);
+    if (useXcb) {
+        /* so the first transition does not wait for the extension queries */
+        xcb_prefetch_extension_data(XGetXCBConnection(disp), &xcb_randr_id);
+        xcb_prefetch_extension_data(XGetXCBConnection(disp), &xcb_input_id);
+    }
+    XSetErrorHandler(ignoreXError);
+    return disp;
+}
+
+/* What the CRTC of the output was last rotated to, by us or anyone
+ * else, and whether an input device came since the last look. The
+ * screen-wide rotation in RRScreenChangeNotify is that of the primary
+ * or first CRTC, which need not be ours. */
+static Rotation crtcRotation = 0;
+static int xiAdded = 0;
+
+/* Drains the queued events without blocking; only drops the cache when
+ * RandR reports a change, so a quiet tick costs no round trip. */
+void processXEvents(Display *disp) {
+    while (XPending(disp)) {
+        XEvent ev;
+        XNextEvent(disp, &ev);
+        if (ev.type == rrEventBase + RRScreenChangeNotify) {
+            XRRUpdateConfiguration(&ev);
+            invalidateRRCache();
+        } else if (ev.type == rrEventBase + RRNotify) {
+            XRRCrtcChangeNotifyEvent *cc = (XRRCrtcChangeNotifyEvent *)&ev;
+            if (cc->subtype == RRNotify_CrtcChange && cc->crtc == rrCache.crtc)
+                crtcRotation = cc->rotation & 0xF;
+            invalidateRRCache();
+        }
+        else if (ev.type == GenericEvent && ev.xcookie.extension == xiOpcode &&
+                ev.xcookie.evtype == XI_HierarchyChanged) {
+            xiCache.valid = 0;
+            if (XGetEventData(disp, &ev.xcookie)) {
+                xiAdded |= !!(((XIHierarchyEvent *)ev.xcookie.data)->flags & XISlaveAdded);
+                XFreeEventData(disp, &ev.xcookie);
+            }
+        }
+    }
+}
+
+RRCrtc findRROutput(Display *disp) {
+    if (!rrCache.valid && !(useXcb ? loadCachesXcb(disp, 1, !xiCache.valid) : loadRRCache(disp)))
+        return None;
+    return rrCache.crtc;
+}
+
+int rotateScreen(Display *disp, Orientation targetRR) {
+    if (!targetRR) return 0;
+    if (!findRROutput(disp)) return 0;
+
+    int scr = DefaultScreen(disp);
+    int ow = DisplayWidth(disp, scr),
+        oh = DisplayHeight(disp, scr),
+        owmm = DisplayWidthMM(disp, scr),
+        ohmm = DisplayHeightMM(disp, scr);
+    if (rrCache.width == ow && rrCache.height == oh &&
+            targetRR != (rrCache.rotation & 0xF)) {
+        if (needSwapDims(rrCache.rotation & 0xF, targetRR)) {
+            int ssx;
+            ssx = ow; ow = oh; oh = ssx;
+            ssx = owmm; owmm = ohmm; ohmm = ssx;
+        }
+        Rotation rotation = (rrCache.rotation & ~0xF) | targetRR;
+        if (useXcb) {
+            /* nothing waits for the reply, the notify events will do */
+            xcb_connection_t *c = XGetXCBConnection(disp);
+            xcb_randr_output_t outputs[maxCrtcOutputs];
+            for (int i = 0; i < rrCache.noutput; ++i) outputs[i] = rrCache.outputs[i];
+            xcb_randr_set_crtc_config_cookie_t set = xcb_randr_set_crtc_config(c, rrCache.crtc,
+                rrCache.timestamp, rrCache.configTimestamp, rrCache.x, rrCache.y,
+                rrCache.mode, rotation, rrCache.noutput, outputs);
+            xcb_discard_reply(c, set.sequence);
+            xcb_randr_set_screen_size(c, DefaultRootWindow(disp), ow, oh, owmm, ohmm);
+        } else {
+            XRRScreenResources screen = {.configTimestamp = rrCache.configTimestamp};
+            XRRSetCrtcConfig (disp, &screen, rrCache.crtc, rrCache.timestamp,
+                rrCache.x, rrCache.y, rrCache.mode, rotation,
+                rrCache.outputs, rrCache.noutput);
+            statCount(statXRoundTrips);
+            XRRSetScreenSize (disp, DefaultRootWindow(disp), ow, oh, owmm, ohmm);
+        }
+        /* the notify events for this change will refresh the timestamps */
+        invalidateRRCache();
+    }
+    float const *m;
+    switch (targetRR) {
+    case upward: m = upMatrix; break;
+    case downward: m = downMatrix; break;
+    case leftward: m = leftMatrix; break;
+    case rightward: m = rightMatrix; break;
+    }
+    setMatrix(disp, touchDevs, m);
+    setMatrix(disp, penDevs, m);
+    switch (targetRR) {
+    case upward: m = rightMatrix; break;
+    case downward: m = leftMatrix; break;
+    case leftward: m = upMatrix; break;
+    case rightward: m = downMatrix; break;
+    }
+    setMatrix(disp, vpadDevs, m);
+    return 1;
+}
+
+/* The screen saver says when it starts and stops, and DPMS 1.2 sends an
+ * event on every level change; the level itself is asked for then. Older
+ * servers have no DPMS events, so it is polled, but only every dormantMs:
+ * waking the display up rotates as soon as it is seen on, and the
+ * accelerometers are read at that rate anyway while it is off. The
+ * watcher has a connection of its own, read on the event loop, while the
+ * actuators' one is used by their lane. */
+static Display *watchDisp;
+static int saverEvent = -1, haveDpms = 0, saverOn = 0;
+
+static void checkDisplay() {
+    CARD16 level = DPMSModeOn;
+    BOOL enabled = False;
+    if (haveDpms) DPMSInfo(watchDisp, &level, &enabled);
+    setDisplayOff(saverOn || (enabled && level != DPMSModeOn));
+}
+
+/* The DPMSInfoNotify generic events have no Xlib handler, so XPending
+ * drops them; they are only there to wake the loop up. */
+static void onWatchEvents(void *ctx, int fd) {
+    while (XPending(watchDisp)) {
+        XEvent ev;
+        XNextEvent(watchDisp, &ev);
+        if (saverEvent >= 0 && ev.type == saverEvent + ScreenSaverNotify)
+            saverOn = ((XScreenSaverNotifyEvent *)&ev)->state == ScreenSaverOn;
+    }
+    checkDisplay();
+}
+
+static void onDpmsTimer(void *ctx, int fd) {
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) checkDisplay();
+}
+
+/* DPMSSelectInput is only in libXext from 1.3.6 on; this is the request. */
+static int selectDpmsEvents(Display *dpy) {
+    int opcode, event, error, major, minor;
+    if (!XQueryExtension(dpy, DPMSExtensionName, &opcode, &event, &error) ||
+            !DPMSGetVersion(dpy, &major, &minor) || major * 100 + minor < 102 ||
+            !XGEQueryVersion(dpy, &major, &minor)) return 0;
+    xDPMSSelectInputReq *req;
+    LockDisplay(dpy);
+    GetReq(DPMSSelectInput, req);
+    req->reqType = opcode;
+    req->dpmsReqType = X_DPMSSelectInput;
+    req->eventMask = DPMSInfoNotifyMask;
+    UnlockDisplay(dpy);
+    SyncHandle();
+    return 1;
+}
+
+static void startDisplayWatch() {
+    int ssError, dpmsEvent, dpmsError;
+    if (!(watchDisp = XOpenDisplay(NULL))) return;
+    if (!XScreenSaverQueryExtension(watchDisp, &saverEvent, &ssError)) saverEvent = -1;
+    haveDpms = DPMSQueryExtension(watchDisp, &dpmsEvent, &dpmsError) && DPMSCapable(watchDisp);
+    if (saverEvent < 0 && !haveDpms) {
+        XCloseDisplay(watchDisp);
+        return;
+    }
+    if (saverEvent >= 0)
+        XScreenSaverSelectInput(watchDisp, DefaultRootWindow(watchDisp), ScreenSaverNotifyMask);
+    int dpmsEvents = haveDpms && selectDpmsEvents(watchDisp);
+    XFlush(watchDisp);
+    watchFd(ConnectionNumber(watchDisp), onWatchEvents, NULL, timeXHandled, 0);
+    if (haveDpms && !dpmsEvents) watchTimer(dormantMs, onDpmsTimer, NULL, timeXHandled);
+    checkDisplay();
+}
+
+/* Both X actuators share one connection, on one lane, and drain its
+ * events once per decision, before the first of them acts. Its fd is
+ * watched on the loop too, edge triggered as the lane reads it, so a
+ * change made by another client gets the lane to look at once. */
+static Display *disp;
+static long long eventsAt = -1;
+
+static void onXEvents(void *ctx, int fd) {
+    refreshLane(xLane);
+}
+
+static void initX() {
+    static int watching = 0;
+    if (!watching) {
+        /* the lane and the loop use Xlib from their own threads */
+        XInitThreads();
+        startDisplayWatch();
+        watching = 1;
+    }
+    if (!disp && (disp = openDisplay())) watchFd(ConnectionNumber(disp), onXEvents, NULL, timeXHandled, 1);
+}
+
+static Display *xReady(Decision const *d) {
+    if (!disp && !(disp = openDisplay())) return NULL;
+    if (eventsAt != d->now) {
+        processXEvents(disp);
+        eventsAt = d->now;
+    }
+    return disp;
+}
+
+static Orientation lastOrient = horizontal;
+
+/* also puts the screen back when someone else has turned it */
+static void applyRotation(Decision const *d) {
+    if (d->orient == horizontal) return;
+    Display *x = xReady(d);
+    if (!x || (d->orient == lastOrient && crtcRotation == lastOrient)) return;
+    statCount(statXTransitions);
+    crtcRotation = lastOrient = d->orient;
+    statTimed(timeRotate, rotateScreen(x, lastOrient));
+    XFlush(x);
+    statTime(timeRotateDone, nowNs() - d->now);
+    logAction(logRotate, lastOrient, nowNs() - d->now, rrOutputName ? rrOutputName : "primary");
+}
+
+Actuator const rotateActuator = {"rotate", 0, initX, applyRotation, NULL, xLane};
+
+static Formfactor lastFF = undefinedFF;
+
+/* the halo keyboard and its touchpad only make sense in laptop mode */
+static void applyInput(Decision const *d) {
+    if (d->ff == undefinedFF || d->ff == borderFF) return;
+    Display *x = xReady(d);
+    if (!x || (d->ff == lastFF && !xiAdded)) return;
+    xiAdded = 0;
+    statCount(statXTransitions);
+    unsigned char enabled = laptop == (lastFF = d->ff);
+    modifyProperty(x, vkbdDevs, xiAtoms[enabledAtom], XA_INTEGER, 8, &enabled, 1);
+    modifyProperty(x, vpadDevs, xiAtoms[enabledAtom], XA_INTEGER, 8, &enabled, 1);
+    XFlush(x);
+    statTime(timeInputDone, nowNs() - d->now);
+    logAction(logInput, enabled, nowNs() - d->now, xiTargetNames[vkbdDevs]);
+}
+
+Actuator const inputActuator = {"input", 0, initX, applyInput, NULL, xLane};
@@ -0,0 +1,24 @@
+#ifndef XACT_H
+#define XACT_H
+
+#include <X11/Xlib.h>
+#include "decide.h"
+
+/* The X side of the rotate and input actuators, exposed for bench. */
+enum XiTarget {touchDevs, penDevs, vkbdDevs, vpadDevs, nrXiTargets};
+enum {matrixAtom, enabledAtom, floatAtom, nrXiAtoms};
+extern Atom xiAtoms[nrXiAtoms];
+
+Display *openDisplay();
+void processXEvents(Display *disp);
+/* The RandR output rotated, "DSI-1" on the YB1; NULL for the primary
+ * one or, without a primary, the first connected. */
+extern char const *rrOutputName;
+/* the CRTC of that output, None when it is not there */
+RRCrtc findRROutput(Display *disp);
+/* 0 when there is no output to turn, else the change is queued */
+int rotateScreen(Display *disp, Orientation targetRR);
+void modifyProperty(Display *disp, enum XiTarget target, Atom property,
+        Atom type, int format, void *content, int count);
+
+#endif
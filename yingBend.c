@@ -0,0 +1,10 @@
+#include <stddef.h>
+#include "core.h"
+#include "actuators.h"
+
+/* Every actuator from one sample stream, pick a subset with -a. */
+int main(int argc, char *argv[]) {
+    static Actuator const *const actuators[] = {&rotateActuator, &inputActuator,
+        &backlightActuator, &driversActuator, &tabletModeActuator, NULL};
+    return runDaemon(argc, argv, actuators);
+}
@@ -0,0 +1,105 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "ringlog.h"
+#include "statepage.h"
+
+/* Turns the daemon's ring log into text, oldest record first, or with
+ * -c into CSV:
+ *     yingLog [-c] [file] */
+static char const *typeNames[nrLogTypes] = {"?", "tick", "rotate", "input", "bind",
+    "uevent", "backlight", "display", "rediscover", "motion", "tabletmode"};
+
+static int bySeq(void const *a, void const *b) {
+    uint64_t x = ((LogRecord const *)a)->seq, y = ((LogRecord const *)b)->seq;
+    return x < y ? -1 : x > y;
+}
+
+static void printText(LogRecord const *r) {
+    printf("%12.3f %-10s", r->ns / 1e9, r->type < nrLogTypes ? typeNames[r->type] : "?");
+    switch (r->type) {
+    case logTick:
+        printf(" %-9s %-5s %s%s%s", stateOrientName(r->orient), stateFormName[r->ff & 3],
+                r->flags & logRejected ? "rejected " : "", r->flags & logDormant ? "dormant " : "",
+                r->flags & logSettled ? "settled " : "");
+        for (int i = 0; i < 4; ++i)
+            printf(" %d,%d,%d", r->u.raw.accel[i][0], r->u.raw.accel[i][1], r->u.raw.accel[i][2]);
+        printf(" als %d,%d", r->u.raw.als[0], r->u.raw.als[1]);
+        if (r->value) printf(" bl %.3f", r->value / 1000.0);
+        printf(" took %lldus\n", (long long)r->latencyNs / 1000);
+        break;
+    case logRotate:
+        printf(" %s %s after %lldus\n", r->u.name, stateOrientName(r->value), (long long)r->latencyNs / 1000);
+        break;
+    case logInput:
+        printf(" %s %s after %lldus\n", r->u.name, r->value ? "enabled" : "disabled",
+                (long long)r->latencyNs / 1000);
+        break;
+    case logBind:
+        printf(" %s %s after %lldus\n", r->u.name, r->value < 0 ? "failed" :
+                r->value ? "bound" : "unbound", (long long)r->latencyNs / 1000);
+        break;
+    case logUevent:
+        printf(" %s now %s\n", r->u.name, r->value ? "bound" : "unbound");
+        break;
+    case logTabletMode:
+        printf(" %s %s after %lldus\n", r->u.name, r->value ? "tablet" : "laptop",
+                (long long)r->latencyNs / 1000);
+        break;
+    case logBacklight:
+        printf(" %s to %.3f\n", r->u.name, r->value / 1000.0);
+        break;
+    case logMotion:
+        printf(" %d events\n", r->value);
+        break;
+    case logDisplay:
+        printf(" %s\n", r->value ? "off" : "on");
+        break;
+    default:
+        printf("\n");
+    }
+}
+
+static void printCsv(LogRecord const *r) {
+    printf("%llu,%lld,%s,%d,%d,%d,%d,%lld,", (unsigned long long)r->seq, (long long)r->ns,
+            r->type < nrLogTypes ? typeNames[r->type] : "?", r->orient, r->ff, r->flags,
+            r->value, (long long)r->latencyNs);
+    if (r->type == logTick) {
+        for (int i = 0; i < 4; ++i) for (int j = 0; j < 3; ++j) printf(",%d", r->u.raw.accel[i][j]);
+        printf(",%d,%d\n", r->u.raw.als[0], r->u.raw.als[1]);
+    } else {
+        printf("%.*s", (int)sizeof(r->u.name), r->u.name);
+        for (int i = 0; i < 14; ++i) printf(",");
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int csv = 0;
+    char const *fn = NULL;
+    char dflt[PATH_MAX];
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp("-c", argv[i])) csv = 1;
+        else fn = argv[i];
+    }
+    if (!fn) fn = runtimePath(dflt, "log");
+    FILE *f = fopen(fn, "rb");
+    RingLogHeader h;
+    if (!f || fread(&h, sizeof(h), 1, f) != 1 || memcmp(h.magic, ringLogMagic, sizeof(h.magic))
+            || h.recordSize != sizeof(LogRecord)) {
+        fprintf(stderr, "%s is not a ying-bend log.\n", fn);
+        return 1;
+    }
+    LogRecord *rs = malloc(h.records * sizeof(LogRecord));
+    int n = rs ? fread(rs, sizeof(LogRecord), h.records, f) : 0;
+    fclose(f);
+    /* records being written, or never written, have no seq */
+    int kept = 0;
+    for (int i = 0; i < n; ++i) if (rs[i].seq) rs[kept++] = rs[i];
+    qsort(rs, kept, sizeof(LogRecord), bySeq);
+    if (csv) printf("seq,ns,type,orient,ff,flags,value,latency_ns,name,"
+            "a0x,a0y,a0z,a1x,a1y,a1z,a2x,a2y,a2z,a3x,a3y,a3z,als0,als1\n");
+    for (int i = 0; i < kept; ++i) (csv ? printCsv : printText)(&rs[i]);
+    free(rs);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "statepage.h"
+
+/* Prints what the daemon last decided, from its state page, or with -w
+ * a line on every change, for scripts:
+ *     yingState [-w] [file] */
+static void print(YingState const *s) {
+    double screen[3], keyboard[3];
+    statePolar(s->screen, screen);
+    statePolar(s->keyboard, keyboard);
+    printf("%s %s %.2f %.2f %.2f %.2f %.2f %.2f %.2f %llu\n", stateOrientName(s->orient),
+            stateFormName[s->ff & 3], screen[0], screen[1], screen[2],
+            keyboard[0], keyboard[1], keyboard[2], s->backlight,
+            (unsigned long long)s->sample);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    int follow = 0;
+    char const *fn = NULL;
+    char dflt[PATH_MAX];
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp("-w", argv[i])) follow = 1;
+        else fn = argv[i];
+    }
+    if (!fn) fn = runtimePath(dflt, "state");
+    StatePage const *p = mapState(fn);
+    if (!p) {
+        perror(fn);
+        return 1;
+    }
+    YingState s;
+    uint32_t seen = p->changes;
+    if (readState(p, &s)) {
+        fprintf(stderr, "%s was left half written.\n", fn);
+        return 1;
+    }
+    print(&s);
+    while (follow) {
+        uint32_t now = waitState(p, seen, -1);
+        if (now == seen) continue;
+        seen = now;
+        /* a restarted daemon rewrites it, wait for that */
+        if (!readState(p, &s)) print(&s);
+    }
+    return 0;
+}